@@ -0,0 +1,76 @@
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// A connection per request: connect, ask for the map list with "Connection: close" and read until the server
+// closes. What limits the rate is accepting and setting up sessions, not serving.
+bool OneConnection(net::io_context &ioc, const tcp::endpoint &endpoint) {
+    static constexpr std::string_view request = "GET /api/v1/maps HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+
+    boost::system::error_code ec;
+    tcp::socket socket{ioc};
+    socket.connect(endpoint, ec);
+    if (ec) {
+        return false;
+    }
+    net::write(socket, net::buffer(request), ec);
+    if (ec) {
+        return false;
+    }
+
+    std::string response;
+    net::read(socket, net::dynamic_buffer(response), ec);
+    return ec == net::error::eof && response.starts_with("HTTP/1.1 200"sv);
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    const auto port = static_cast<unsigned short>(argc > 2 ? std::stoul(argv[2]) : 8080);
+    const unsigned threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    const auto duration = std::chrono::seconds{argc > 4 ? std::stoul(argv[4]) : 5};
+
+    const tcp::endpoint endpoint{net::ip::make_address(host), port};
+    std::cout << "clients: " << threads << ", seconds: " << duration.count() << '\n';
+
+    std::atomic<std::size_t> succeeded = 0;
+    std::atomic<std::size_t> failed = 0;
+    const auto deadline = Clock::now() + duration;
+    {
+        std::vector<std::jthread> clients;
+        for (unsigned i = 0; i < threads; ++i) {
+            clients.emplace_back([&] {
+                net::io_context ioc;
+                std::size_t ok = 0, errors = 0;
+                while (Clock::now() < deadline) {
+                    ++(OneConnection(ioc, endpoint) ? ok : errors);
+                }
+                succeeded += ok;
+                failed += errors;
+            });
+        }
+    }
+
+    std::cout << "connections: " << succeeded << ", failed: " << failed << '\n';
+    std::cout << "accept rate: " << static_cast<double>(succeeded) / duration.count() << " connections per second\n";
+    return failed == 0 ? 0 : 1;
+}
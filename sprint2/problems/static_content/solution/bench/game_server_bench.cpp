@@ -0,0 +1,319 @@
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/program_options.hpp>
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.hpp"
+#include "util/json_writer.hpp"
+
+using namespace std::literals;
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace json = boost::json;
+using tcp = net::ip::tcp;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1"s;
+    unsigned short port = 8080;
+    unsigned connections = 16;
+    unsigned duration = 10;
+    // Requests per second of all the clients together, 0 runs a closed loop
+    double rate = 0;
+    std::string map;
+    std::string static_target = "/index.html"s;
+    std::string json_output;
+};
+
+enum Operation { JOIN, ACTION, STATE, STATIC, OPERATIONS };
+constexpr std::array<std::string_view, OPERATIONS> OPERATION_NAMES{"join"sv, "action"sv, "state"sv, "static"sv};
+
+struct Stats {
+    std::array<bench::LatencyHistogram, OPERATIONS> latency;
+    std::array<std::uint64_t, OPERATIONS> errors{};
+
+    void Merge(const Stats &other) {
+        for (int i = 0; i < OPERATIONS; ++i) {
+            latency[i].Merge(other.latency[i]);
+            errors[i] += other.errors[i];
+        }
+    }
+};
+
+// One player of the game on a keep-alive connection. Sends its requests one at a time, like the browser client.
+class Client {
+  public:
+    Client(const Options &options, const tcp::endpoint &endpoint) : options_(options), endpoint_(endpoint) {}
+
+    // join -> (action -> state -> static file) until the deadline. In the open loop request i is due at
+    // start + i * interval and its latency counts from then, so a stalled server is not hidden by a client
+    // that waits for it.
+    Stats Run(Clock::time_point start, Clock::time_point deadline, std::optional<Clock::duration> interval) {
+        Stats stats;
+        auto due = start;
+        auto next = [&] {
+            if (interval) {
+                due += *interval;
+                std::this_thread::sleep_until(due);
+            }
+            return interval ? due : Clock::now();
+        };
+
+        std::this_thread::sleep_until(start);
+        std::string token;
+        while (token.empty() && Clock::now() < deadline) {
+            std::string body;
+            util::JsonWriter{body}
+                .BeginObject()
+                .Key("userName"sv)
+                .String("bench"sv)
+                .Key("mapId"sv)
+                .String(options_.map)
+                .EndObject();
+            auto response = Request(stats, JOIN, http::verb::post, "/api/v1/game/join"sv, {}, body, next());
+            if (response) {
+                token = json::parse(*response).as_object().at("authToken").as_string().c_str();
+            }
+        }
+
+        static constexpr std::array<std::string_view, 4> moves{"L"sv, "R"sv, "U"sv, "D"sv};
+        for (std::size_t i = 0; Clock::now() < deadline; ++i) {
+            auto body = R"({"move": ")"s + std::string{moves[i % moves.size()]} + "\"}";
+            Request(stats, ACTION, http::verb::post, "/api/v1/game/player/action"sv, token, body, next());
+            Request(stats, STATE, http::verb::get, "/api/v1/game/state"sv, token, {}, next());
+            Request(stats, STATIC, http::verb::get, options_.static_target, {}, {}, next());
+        }
+        return stats;
+    }
+
+  private:
+    // Body of a successful response, nullopt if the request failed. Failed connections are opened again.
+    std::optional<std::string> Request(Stats &stats, Operation operation, http::verb method, std::string_view target,
+                                       std::string_view token, std::string_view body, Clock::time_point start) {
+        http::request<http::string_body> request{method, target, 11};
+        request.set(http::field::host, options_.host);
+        if (!token.empty()) {
+            request.set(http::field::authorization, "Bearer "s + std::string{token});
+        }
+        if (!body.empty()) {
+            request.set(http::field::content_type, "application/json"sv);
+            request.body() = body;
+        }
+        request.prepare_payload();
+
+        beast::error_code ec;
+        if (!stream_.socket().is_open()) {
+            stream_.connect(endpoint_, ec);
+        }
+        http::response<http::string_body> response;
+        if (!ec) {
+            http::write(stream_, request, ec);
+        }
+        if (!ec) {
+            http::read(stream_, buffer_, response, ec);
+        }
+        if (ec) {
+            stream_.socket().close(ec);
+            buffer_.clear();
+            ++stats.errors[operation];
+            return std::nullopt;
+        }
+
+        stats.latency[operation].Record(std::chrono::nanoseconds{Clock::now() - start}.count());
+        if (response.result_int() >= 300) {
+            ++stats.errors[operation];
+            return std::nullopt;
+        }
+        return std::move(response.body());
+    }
+
+    const Options &options_;
+    tcp::endpoint endpoint_;
+    net::io_context ioc_;
+    beast::tcp_stream stream_{ioc_};
+    beast::flat_buffer buffer_;
+};
+
+// The first map of the server, if none was given
+std::string FirstMap(const tcp::endpoint &endpoint) {
+    net::io_context ioc;
+    beast::tcp_stream stream{ioc};
+    stream.connect(endpoint);
+    http::request<http::string_body> request{http::verb::get, "/api/v1/maps", 11};
+    request.set(http::field::host, endpoint.address().to_string());
+    http::write(stream, request);
+
+    beast::flat_buffer buffer;
+    http::response<http::string_body> response;
+    http::read(stream, buffer, response);
+    return json::parse(response.body()).as_array().at(0).as_object().at("id").as_string().c_str();
+}
+
+void WriteStats(util::JsonWriter &writer, const bench::LatencyHistogram &latency, std::uint64_t errors,
+                double seconds) {
+    auto us = [](std::uint64_t ns) { return static_cast<double>(ns) / 1000; };
+    writer.BeginObject();
+    writer.Key("requests"sv).Number(latency.Count());
+    writer.Key("errors"sv).Number(errors);
+    writer.Key("rps"sv).Number(latency.Count() / seconds);
+    writer.Key("mean_us"sv).Number(latency.Mean() / 1000);
+    writer.Key("p50_us"sv).Number(us(latency.Percentile(0.5)));
+    writer.Key("p90_us"sv).Number(us(latency.Percentile(0.9)));
+    writer.Key("p99_us"sv).Number(us(latency.Percentile(0.99)));
+    writer.Key("p999_us"sv).Number(us(latency.Percentile(0.999)));
+    writer.Key("max_us"sv).Number(us(latency.Max()));
+    writer.EndObject();
+}
+
+std::string Report(const Options &options, const Stats &stats, double seconds) {
+    std::string out;
+    util::JsonWriter writer{out};
+    writer.BeginObject();
+    writer.Key("config"sv).BeginObject();
+    writer.Key("connections"sv).Number(std::uint64_t{options.connections});
+    writer.Key("duration_s"sv).Number(seconds);
+    writer.Key("mode"sv).String(options.rate > 0 ? "open"sv : "closed"sv);
+    writer.Key("rate"sv).Number(options.rate);
+    writer.Key("map"sv).String(options.map);
+    writer.Key("static"sv).String(options.static_target);
+    writer.EndObject();
+
+    bench::LatencyHistogram total;
+    std::uint64_t total_errors = 0;
+    writer.Key("operations"sv).BeginObject();
+    for (int i = 0; i < OPERATIONS; ++i) {
+        writer.Key(OPERATION_NAMES[i]);
+        WriteStats(writer, stats.latency[i], stats.errors[i], seconds);
+        total.Merge(stats.latency[i]);
+        total_errors += stats.errors[i];
+    }
+    writer.EndObject();
+    writer.Key("total"sv);
+    WriteStats(writer, total, total_errors, seconds);
+    writer.EndObject();
+    return out;
+}
+
+void PrintTable(const Stats &stats, double seconds) {
+    auto ms = [](std::uint64_t ns) { return static_cast<double>(ns) / 1'000'000; };
+    std::cout << std::left << std::setw(8) << "" << std::right << std::setw(10) << "requests" << std::setw(8)
+              << "errors" << std::setw(10) << "rps" << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms"
+              << std::setw(10) << "p999 ms" << std::setw(10) << "max ms" << '\n';
+    std::cout << std::fixed << std::setprecision(2);
+    for (int i = 0; i < OPERATIONS; ++i) {
+        const auto &latency = stats.latency[i];
+        std::cout << std::left << std::setw(8) << OPERATION_NAMES[i] << std::right << std::setw(10)
+                  << latency.Count() << std::setw(8) << stats.errors[i] << std::setw(10) << latency.Count() / seconds
+                  << std::setw(10) << ms(latency.Percentile(0.5)) << std::setw(10) << ms(latency.Percentile(0.99))
+                  << std::setw(10) << ms(latency.Percentile(0.999)) << std::setw(10) << ms(latency.Max()) << '\n';
+    }
+}
+
+std::optional<Options> ParseCommandLine(int argc, const char *const argv[]) {
+    namespace po = boost::program_options;
+
+    Options options;
+    po::options_description desc{"All options"s};
+    // clang-format off
+    desc.add_options()
+        ("help,h", "Show help")
+        ("host", po::value(&options.host)->value_name("address"s), "server address, 127.0.0.1 by default")
+        ("port", po::value(&options.port)->value_name("port"s), "server port, 8080 by default")
+        ("connections,c", po::value(&options.connections)->value_name("count"s), "concurrent players, 16 by default")
+        ("duration,d", po::value(&options.duration)->value_name("seconds"s), "test duration, 10 by default")
+        ("rate,r", po::value(&options.rate)->value_name("requests"s),
+            "requests per second in total for an open loop, closed loop by default")
+        ("map", po::value(&options.map)->value_name("id"s), "map to join, the first one by default")
+        ("static", po::value(&options.static_target)->value_name("target"s), "static file to fetch")
+        ("json", po::value(&options.json_output)->value_name("file"s), "write the results as JSON, - for stdout");
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.contains("help"s)) {
+        std::cout << desc;
+        return std::nullopt;
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    try {
+        auto options = ParseCommandLine(argc, argv);
+        if (!options) {
+            return EXIT_SUCCESS;
+        }
+        const tcp::endpoint endpoint{net::ip::make_address(options->host), options->port};
+        if (options->map.empty()) {
+            options->map = FirstMap(endpoint);
+        }
+
+        std::optional<Clock::duration> interval;
+        if (options->rate > 0) {
+            interval = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>{options->connections / options->rate});
+        }
+        std::cerr << "connections: " << options->connections << ", seconds: " << options->duration;
+        if (interval) {
+            std::cerr << ", open loop at " << options->rate << " rps\n";
+        } else {
+            std::cerr << ", closed loop\n";
+        }
+
+        const auto start = Clock::now() + 100ms;
+        const auto deadline = start + std::chrono::seconds{options->duration};
+        std::vector<Stats> results(options->connections);
+        {
+            std::vector<std::jthread> clients;
+            for (unsigned i = 0; i < options->connections; ++i) {
+                // Clients of the open loop start evenly spread over one interval
+                auto client_start = interval ? start + *interval * i / options->connections : start;
+                clients.emplace_back([&, i, client_start] {
+                    Client client{*options, endpoint};
+                    results[i] = client.Run(client_start, deadline, interval);
+                });
+            }
+        }
+
+        Stats stats;
+        for (const auto &result : results) {
+            stats.Merge(result);
+        }
+        const double seconds = options->duration;
+        PrintTable(stats, seconds);
+
+        if (!options->json_output.empty()) {
+            auto report = Report(*options, stats, seconds);
+            if (options->json_output == "-"sv) {
+                std::cout << report << '\n';
+            } else {
+                std::ofstream{options->json_output} << report << '\n';
+            }
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception &ex) {
+        std::cerr << ex.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
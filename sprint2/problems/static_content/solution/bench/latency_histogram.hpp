@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+// Latency histogram in the manner of HdrHistogram: values below 256 ns get a bucket each, above that every power
+// of two is split into 128 buckets, so any recorded value is off by less than 1% and the whole uint64 range fits
+// in a few thousand counters. Recording is a couple of bit operations.
+class LatencyHistogram {
+  public:
+    LatencyHistogram() : counts_(BucketOf(UINT64_MAX) + 1) {}
+
+    void Record(std::uint64_t nanoseconds) {
+        ++counts_[BucketOf(nanoseconds)];
+        ++count_;
+        sum_ += nanoseconds;
+        max_ = std::max(max_, nanoseconds);
+    }
+
+    void Merge(const LatencyHistogram &other) {
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    std::uint64_t Count() const { return count_; }
+    std::uint64_t Max() const { return max_; }
+    double Mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0; }
+
+    // Smallest value that at least the given fraction of recorded values does not exceed, 0.99 for p99
+    std::uint64_t Percentile(double fraction) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * count_)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= target) {
+                return std::min(HighestOf(i), max_);
+            }
+        }
+        return max_;
+    }
+
+  private:
+    static constexpr unsigned SUB_BITS = 7;
+    static constexpr std::uint64_t SUB_BUCKETS = std::uint64_t{1} << SUB_BITS;
+
+    static std::size_t BucketOf(std::uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) {
+            return value;
+        }
+        const unsigned shift = std::bit_width(value) - (SUB_BITS + 1);
+        return (shift + 1) * SUB_BUCKETS + (value >> shift) - SUB_BUCKETS;
+    }
+
+    // Largest value that falls into the bucket
+    static std::uint64_t HighestOf(std::size_t bucket) {
+        if (bucket < 2 * SUB_BUCKETS) {
+            return bucket;
+        }
+        const std::uint64_t shift = bucket / SUB_BUCKETS - 1;
+        const std::uint64_t mantissa = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+} // namespace bench
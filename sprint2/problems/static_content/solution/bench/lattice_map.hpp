@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "model/model.hpp"
+
+namespace bench {
+
+// Square lattice of blocks x blocks cells, every cell side is a separate road
+inline model::Map MakeLatticeMap(std::string id, int blocks, int step) {
+    model::Map::Roads roads;
+    for (int i = 0; i <= blocks; ++i) {
+        for (int j = 0; j < blocks; ++j) {
+            roads.emplace_back(model::Orientation::HORIZONTAL, model::Point{j * step, i * step}, (j + 1) * step);
+            roads.emplace_back(model::Orientation::VERTICAL, model::Point{i * step, j * step}, (j + 1) * step);
+        }
+    }
+    auto map = model::Map{model::Map::Id{id}, id, std::move(roads), {}, {}};
+    map.SetDogSpeed(3.0);
+    return map;
+}
+
+// Join dogs players to the session and send each of them along the road it has been spawned on
+inline void AddMovingDogs(model::Game &game, model::GameSession &session, int dogs) {
+    const auto &map = session.GetMap();
+    for (int i = 0; i < dogs; ++i) {
+        auto [player, _] = game.AddPlayer("dog" + std::to_string(i), session);
+        auto speed = *map.GetDogSpeed() * (i % 2 ? 1 : -1);
+        auto [x, y] = player->GetDog()->GetPosition();
+        bool on_horizontal = map.FindRoad(model::Orientation::HORIZONTAL,
+                                          model::Point{static_cast<int>(x), static_cast<int>(y)});
+        player->GetDog()->SetSpeed(on_horizontal ? std::pair{speed, 0.0} : std::pair{0.0, speed});
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,86 @@
+#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/utility/setup/console.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.hpp"
+#include "util/logging.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Mode {
+    std::string_view name;
+    util::LogMode mode;
+    util::LogOverflow overflow = util::LogOverflow::DROP;
+};
+
+// The two records of a request on the threads of the server, the latency of every pair is recorded
+bench::LatencyHistogram LogRequests(std::size_t requests) {
+    bench::LatencyHistogram latency;
+    for (std::size_t i = 0; i < requests; ++i) {
+        auto start = Clock::now();
+        util::LogRequest("127.0.0.1"sv, "/api/v1/game/state"sv, "GET"sv);
+        util::LogResponse(0, 200, "application/json"sv);
+        latency.Record(std::chrono::nanoseconds{Clock::now() - start}.count());
+    }
+    return latency;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const unsigned threads = argc > 1 ? std::stoul(argv[1]) : 4;
+    const std::size_t requests = argc > 2 ? std::stoul(argv[2]) : 200'000;
+
+    // Both logs write to /dev/null, so only the cost on the request threads and of formatting is measured
+    std::ofstream null{"/dev/null"};
+    boost::log::add_console_log(null, boost::log::keywords::format = &util::LogFormatter);
+    boost::log::add_common_attributes();
+
+    const Mode modes[] = {{"sync"sv, util::LogMode::SYNC},
+                          {"async"sv, util::LogMode::ASYNC, util::LogOverflow::DROP},
+                          {"async-block"sv, util::LogMode::ASYNC, util::LogOverflow::BLOCK},
+                          {"off"sv, util::LogMode::OFF}};
+
+    std::cout << threads << " threads, " << requests << " requests each\n";
+    std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(12) << "requests/s" << std::setw(10)
+              << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p999 ns" << std::setw(12) << "max ns"
+              << std::setw(12) << "drain ms" << '\n';
+    for (const auto &mode : modes) {
+        util::SetLogMode(mode.mode, null, util::AsyncLogOptions{.overflow = mode.overflow});
+
+        std::vector<bench::LatencyHistogram> results(threads);
+        const auto start = Clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned i = 0; i < threads; ++i) {
+                workers.emplace_back([&results, i, requests] { results[i] = LogRequests(requests); });
+            }
+        }
+        const auto logged = Clock::now();
+        // The async log has written everything once it is replaced
+        util::SetLogMode(util::LogMode::SYNC, null);
+        const auto drained = Clock::now();
+
+        bench::LatencyHistogram latency;
+        for (const auto &result : results) {
+            latency.Merge(result);
+        }
+        const double seconds = std::chrono::duration<double>(logged - start).count();
+        std::cout << std::left << std::setw(12) << mode.name << std::right << std::setw(12) << std::fixed
+                  << std::setprecision(0) << latency.Count() / seconds << std::setw(10) << latency.Percentile(0.5)
+                  << std::setw(10) << latency.Percentile(0.99) << std::setw(10) << latency.Percentile(0.999)
+                  << std::setw(12) << latency.Max() << std::setw(12) << std::setprecision(1)
+                  << std::chrono::duration<double, std::milli>(drained - logged).count() << '\n';
+    }
+}
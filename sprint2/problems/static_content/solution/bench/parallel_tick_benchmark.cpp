@@ -0,0 +1,98 @@
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "api_handler/strands.hpp"
+#include "lattice_map.hpp"
+
+using namespace std::literals;
+
+namespace net = boost::asio;
+
+namespace {
+
+// Ticks every session of the game with the given number of io_context threads, as the server does: the tick of each
+// session is posted onto the strand picked for it. Returns microseconds per tick of the whole game.
+template <typename StrandOf>
+double MeasureTicks(model::Game &game, unsigned threads, int ticks, StrandOf &&strand_of) {
+    net::io_context ioc;
+    auto work = net::make_work_guard(ioc);
+    std::vector<std::jthread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&ioc] { ioc.run(); });
+    }
+    api_handler::Strands strands{ioc, game.GetMaps()};
+
+    const auto sessions = static_cast<std::ptrdiff_t>(game.GetSessions().size());
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) {
+        std::latch done{sessions};
+        for (auto &session : game.GetSessions()) {
+            net::post(strand_of(strands, session), [&session, &done] {
+                session.Tick(5);
+                done.count_down();
+            });
+        }
+        done.wait();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    work.reset();
+    return std::chrono::duration<double, std::micro>(elapsed).count() / ticks;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const int sessions = 64;
+    const int dogs = argc > 1 ? std::stoi(argv[1]) : 10'000;
+    const int ticks = argc > 2 ? std::stoi(argv[2]) : 50;
+    const unsigned max_threads = argc > 3 ? std::stoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+    model::Game::Maps maps;
+    for (int i = 0; i < sessions; ++i) {
+        maps.push_back(bench::MakeLatticeMap("map"s + std::to_string(i), 20, 10));
+    }
+    model::Game game{std::move(maps)};
+    game.SetRandomizeSpawnPoint(true);
+    for (const auto &map : game.GetMaps()) {
+        bench::AddMovingDogs(game, game.AddSession(map), dogs);
+    }
+    // First tick resolves the roads of all freshly spawned dogs, keep it out of the measurements
+    game.Tick(5);
+    std::cout << "sessions: " << sessions << ", dogs per session: " << dogs << ", ticks: " << ticks << '\n';
+
+    auto session_strand = [](api_handler::Strands &strands, const model::GameSession &session) -> auto & {
+        return strands.Session(session.GetMap().GetId());
+    };
+
+    // Scaling of the session strands with the number of server threads: 1, 2, 4 ... max_threads
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    double single_thread_us = 0;
+    for (auto threads : thread_counts) {
+        auto tick_us = MeasureTicks(game, threads, ticks, session_strand);
+        if (threads == 1) {
+            single_thread_us = tick_us;
+        }
+        std::cout << "threads: " << threads << ", tick: " << tick_us << " us, speedup: " << single_thread_us / tick_us
+                  << '\n';
+    }
+
+    // All the sessions on one strand, as before they had strands of their own
+    auto global_us = MeasureTicks(game, max_threads, ticks, [](api_handler::Strands &strands,
+                                                               const model::GameSession &) -> auto & {
+        return strands.Global();
+    });
+    std::cout << "one global strand, threads: " << max_threads << ", tick: " << global_us << " us\n";
+}
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api_handler/router.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Dispatch used by APIHandler before the router: every endpoint matches the target in turn
+class LinearMatcher {
+  public:
+    virtual ~LinearMatcher() = default;
+    virtual bool match(std::string_view target) const = 0;
+};
+
+class ExactMatcher : public LinearMatcher {
+  public:
+    explicit ExactMatcher(std::string route) : route_(std::move(route)) {}
+    bool match(std::string_view target) const override { return target == route_; }
+
+  private:
+    std::string route_;
+};
+
+class PrefixMatcher : public LinearMatcher {
+  public:
+    explicit PrefixMatcher(std::string prefix) : prefix_(std::move(prefix)) {}
+    bool match(std::string_view target) const override {
+        return target.starts_with(prefix_) && !target.ends_with(prefix_);
+    }
+
+  private:
+    std::string prefix_;
+};
+
+template <typename Fn>
+double MeasureNs(std::size_t iterations, Fn &&fn) {
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 5'000'000;
+
+    // The API routes plus generated ones up to 50, every fifth of them with a parameter
+    std::vector<std::string> exact{"/api/v1/maps", "/api/v1/game/join", "/api/v1/game/players", "/api/v1/game/state",
+                                   "/api/v1/game/player/action"};
+    std::vector<std::string> prefixed{"/api/v1/maps/"};
+    for (int i = 0; exact.size() + prefixed.size() < 49; ++i) {
+        if (i % 5 == 4) {
+            prefixed.push_back("/api/v1/extra/route"s + std::to_string(i) + "/");
+        } else {
+            exact.push_back("/api/v1/extra/route"s + std::to_string(i));
+        }
+    }
+
+    std::vector<std::unique_ptr<LinearMatcher>> matchers;
+    api_handler::Router<int> router;
+    const auto any = ~api_handler::Methods{0};
+    int route_id = 0;
+    for (const auto &route : prefixed) {
+        matchers.push_back(std::make_unique<PrefixMatcher>(route));
+        router.Add(route + "{id}", any, route_id++);
+    }
+    for (const auto &route : exact) {
+        matchers.push_back(std::make_unique<ExactMatcher>(route));
+        router.Add(route, any, route_id++);
+    }
+    // The fallthrough endpoint is always the last one to be tried
+    matchers.push_back(std::make_unique<PrefixMatcher>("/api/"));
+    router.Add("/api/*", any, route_id++);
+    std::cout << "routes: " << route_id << ", iterations: " << iterations << '\n';
+
+    // Typical client traffic: mostly state and action, some maps and a few unknown targets
+    const std::vector<std::string> targets{"/api/v1/game/state",   "/api/v1/game/player/action", "/api/v1/game/state",
+                                           "/api/v1/game/players", "/api/v1/maps/map1",          "/api/v1/maps",
+                                           "/api/v1/game/state",   "/api/v1/unknown/target"};
+
+    std::size_t found = 0;
+    auto linear_ns = MeasureNs(iterations, [&](std::size_t i) {
+        const auto &target = targets[i % targets.size()];
+        for (const auto &matcher : matchers) {
+            if (matcher->match(target)) {
+                ++found;
+                break;
+            }
+        }
+    });
+    auto router_ns = MeasureNs(iterations, [&](std::size_t i) {
+        found += router.Find(targets[i % targets.size()]).target != nullptr;
+    });
+
+    std::cout << "linear match: " << linear_ns << " ns per request\n";
+    std::cout << "router: " << router_ns << " ns per request, speedup: " << linear_ns / router_ns << '\n';
+    return found == 2 * iterations ? 0 : 1;
+}
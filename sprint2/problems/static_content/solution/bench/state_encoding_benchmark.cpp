@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "lattice_map.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::size_t size = 0;
+    double us = 0;
+};
+
+// Every response is written into the same buffer, as into the buffer of a connection
+template <typename Writer, typename Response>
+Result Measure(std::size_t iterations, const Response &response) {
+    std::string buffer;
+    std::size_t size = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        buffer.clear();
+        Writer writer{buffer};
+        if constexpr (std::is_same_v<Writer, util::JsonWriter>) {
+            model::api::responses::WriteJson(writer, response);
+        } else {
+            model::api::responses::WriteMsgPack(writer, response);
+        }
+        size += buffer.size();
+    }
+    auto us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+    return {size / iterations, us};
+}
+
+template <typename Response>
+void Compare(std::string_view name, std::size_t iterations, const Response &response) {
+    auto json = Measure<util::JsonWriter>(iterations, response);
+    auto msgpack = Measure<util::MsgPackWriter>(iterations, response);
+    for (auto [encoding, result] : {std::pair{"json"sv, json}, std::pair{"msgpack"sv, msgpack}}) {
+        std::cout << std::left << std::setw(10) << name << std::setw(10) << encoding << std::right << std::setw(12)
+                  << result.size << std::setw(12) << std::fixed << std::setprecision(1) << result.us
+                  << std::setw(12) << std::setprecision(0) << result.size / result.us << '\n';
+    }
+    std::cout << std::setprecision(2) << name << ": msgpack is " << static_cast<double>(json.size) / msgpack.size
+              << "x smaller and " << json.us / msgpack.us << "x faster\n";
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const int dogs = argc > 1 ? std::stoi(argv[1]) : 5'000;
+    const std::size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    model::Game game{{bench::MakeLatticeMap("lattice"s, 70, 10)}};
+    game.SetRandomizeSpawnPoint(true);
+    auto &session = game.AddSession(game.GetMaps().front());
+    bench::AddMovingDogs(game, session, dogs);
+    game.Tick(50);
+    std::cout << "players: " << dogs << ", iterations: " << iterations << '\n';
+    std::cout << std::left << std::setw(10) << "response" << std::setw(10) << "encoding" << std::right
+              << std::setw(12) << "bytes" << std::setw(12) << "us" << std::setw(12) << "MB/s" << '\n';
+
+    const auto &players = session.GetPlayers();
+    Compare("state"sv, iterations, model::api::responses::GetStateResponse{players});
+    Compare("delta"sv, iterations, model::api::responses::GetStateDeltaResponse{players, 0, session.GetTick()});
+    Compare("players"sv, iterations, model::api::responses::GetPlayersResponse{players});
+}
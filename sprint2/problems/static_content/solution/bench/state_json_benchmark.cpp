@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "lattice_map.hpp"
+
+using namespace std::literals;
+
+namespace json = boost::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Fn>
+double MeasureUs(std::size_t iterations, Fn &&fn) {
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const int dogs = argc > 1 ? std::stoi(argv[1]) : 5'000;
+    const std::size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    model::Game game{{bench::MakeLatticeMap("lattice"s, 70, 10)}};
+    game.SetRandomizeSpawnPoint(true);
+    auto &session = game.AddSession(game.GetMaps().front());
+    bench::AddMovingDogs(game, session, dogs);
+    game.Tick(50);
+    std::cout << "players: " << dogs << ", iterations: " << iterations << '\n';
+
+    const model::api::responses::GetStateResponse state{session.GetPlayers()};
+    const model::api::responses::GetPlayersResponse players{session.GetPlayers()};
+
+    // What Response::Json did for every request: build the DOM, then serialize it into a new string
+    std::size_t size = 0;
+    auto dom_state_us = MeasureUs(iterations, [&] { size += json::serialize(json::value_from(state)).size(); });
+    auto dom_players_us = MeasureUs(iterations, [&] { size += json::serialize(json::value_from(players)).size(); });
+
+    // The connection buffer is cleared, not freed, between requests
+    std::string buffer;
+    auto stream_state_us = MeasureUs(iterations, [&] {
+        buffer.clear();
+        util::JsonWriter writer{buffer};
+        model::api::responses::WriteJson(writer, state);
+        size += buffer.size();
+    });
+    auto stream_players_us = MeasureUs(iterations, [&] {
+        buffer.clear();
+        util::JsonWriter writer{buffer};
+        model::api::responses::WriteJson(writer, players);
+        size += buffer.size();
+    });
+
+    std::cout << "state, value + serialize:   " << dom_state_us << " us\n";
+    std::cout << "state, streaming writer:    " << stream_state_us << " us, speedup: " << dom_state_us / stream_state_us
+              << '\n';
+    std::cout << "players, value + serialize: " << dom_players_us << " us\n";
+    std::cout << "players, streaming writer:  " << stream_players_us
+              << " us, speedup: " << dom_players_us / stream_players_us << '\n';
+    return size == 0;
+}
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lattice_map.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Lookup structure used by Game::Tick before the dense road index
+class HashIndex {
+  public:
+    explicit HashIndex(const model::Map::Roads &roads) {
+        for (const auto &road : roads) {
+            auto current_point = road.GetStart(), end_point = road.GetEnd();
+            if (road.IsHorizontal()) {
+                while (current_point.x <= end_point.x) {
+                    index_[model::Orientation::HORIZONTAL][current_point] = &road;
+                    current_point.x += 1;
+                }
+            } else {
+                while (current_point.y <= end_point.y) {
+                    index_[model::Orientation::VERTICAL][current_point] = &road;
+                    current_point.y += 1;
+                }
+            }
+        }
+    }
+
+    const model::Road *Find(model::Orientation orientation, model::Point point) const {
+        return index_.at(orientation).at(point);
+    }
+
+  private:
+    struct PointHash {
+        std::size_t operator()(const model::Point &point) const {
+            return std::hash<int>()(point.x) ^ std::hash<int>()(point.y);
+        }
+    };
+
+    std::unordered_map<model::Orientation, std::unordered_map<model::Point, const model::Road *, PointHash>> index_;
+};
+
+template <typename Fn>
+double MeasureNs(std::size_t iterations, Fn &&fn) {
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    const int dogs = argc > 1 ? std::stoi(argv[1]) : 10'000;
+    const int ticks = argc > 2 ? std::stoi(argv[2]) : 200;
+
+    model::Game game{{bench::MakeLatticeMap("lattice"s, 70, 10)}};
+    game.SetRandomizeSpawnPoint(true);
+    const auto &map = game.GetMaps().front();
+    std::cout << "roads: " << map.GetRoads().size() << ", dogs: " << dogs << ", ticks: " << ticks << '\n';
+
+    // Random points lying on roads, same query stream for both indices
+    std::mt19937 generator{42};
+    std::vector<std::pair<model::Orientation, model::Point>> queries(1 << 16);
+    for (auto &query : queries) {
+        std::uniform_int_distribution<std::size_t> road_dist(0, map.GetRoads().size() - 1);
+        const auto &road = map.GetRoads()[road_dist(generator)];
+        auto start = road.GetStart(), end = road.GetEnd();
+        std::uniform_int_distribution<int> x_dist(start.x, end.x), y_dist(start.y, end.y);
+        query = {road.GetOrientation(), model::Point{x_dist(generator), y_dist(generator)}};
+    }
+
+    const std::size_t lookups = 10'000'000;
+    std::uintptr_t checksum = 0;
+    HashIndex hash_index{map.GetRoads()};
+    auto hash_ns = MeasureNs(lookups, [&](std::size_t i) {
+        const auto &[orientation, point] = queries[i & (queries.size() - 1)];
+        checksum += reinterpret_cast<std::uintptr_t>(hash_index.Find(orientation, point));
+    });
+    auto grid_ns = MeasureNs(lookups, [&](std::size_t i) {
+        const auto &[orientation, point] = queries[i & (queries.size() - 1)];
+        checksum += reinterpret_cast<std::uintptr_t>(map.FindRoad(orientation, point));
+    });
+    std::cout << "lookup, hash of hash: " << hash_ns << " ns\n";
+    std::cout << "lookup, road index:   " << grid_ns << " ns\n";
+
+    auto &session = game.AddSession(map);
+    bench::AddMovingDogs(game, session, dogs);
+
+    auto tick_ns = MeasureNs(ticks, [&](std::size_t) { game.Tick(50); });
+    std::cout << "tick (" << model::DogStore::KernelName() << "): " << tick_ns / 1000.0 << " us, "
+              << tick_ns / dogs << " ns per dog, " << dogs / (tick_ns / 1e6) << " dog updates per ms\n";
+
+    return checksum == 0;
+}
@@ -4,6 +4,7 @@
 #include "util/response.hpp"
 
 #include "endpoints/endpoints.hpp"
+#include "strands.hpp"
 
 namespace api_handler {
 
@@ -13,23 +14,30 @@ using verb = boost::beast::http::verb;
 
 class APIHandler {
   public:
-    APIHandler(model::Game &game) : game_(game), endpoints_(GetEndpoints(game_)) {}
+    using Match = EndpointRouter::Match;
 
+    APIHandler(model::Game &game, Strands &strands) : game_(game), router_(GetEndpoints(game_, strands)) {}
+
+    Match Find(std::string_view target) const { return router_.Find(target); }
+
+    // Hand the request to the endpoint of a route found by Find
     template <typename Body, typename Allocator>
-    bool dispatch(const http::request<Body, http::basic_fields<Allocator>> &request, Response &response) const {
-        for (const auto &endpoint : endpoints_) {
-            if (endpoint->match(request)) {
-                response = endpoint->handle(request);
-                return true;
-            }
+    void Dispatch(const Match &match, const http::request<Body, http::basic_fields<Allocator>> &request,
+                  Endpoint::Respond &&respond) const {
+        if (!match.MethodAllowed(request.method())) {
+            respond(Allows(match.allowed, verb::post) ? model::api::errors::only_post()
+                                                       : model::api::errors::only_get_and_head());
+        } else {
+            (*match.target)->handle(request, std::move(respond));
         }
-
-        return false;
     }
 
+    // Patterns of the API routes, one per route
+    std::vector<std::string_view> Patterns() const { return router_.Patterns(); }
+
   private:
     model::Game &game_;
-    std::vector<std::shared_ptr<Endpoint>> endpoints_;
+    EndpointRouter router_;
 };
 
 } // namespace api_handler
@@ -1,21 +1,133 @@
 #pragma once
 
+#include "api_handler/strands.hpp"
 #include "model/model.hpp"
 #include "util/error.hpp"
 #include "util/response.hpp"
+#include <boost/asio/dispatch.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
 namespace beast = boost::beast;
 namespace http = beast::http;
 namespace json = boost::json;
+namespace net = boost::asio;
 
 class Endpoint {
   public:
-    Endpoint(model::Game &game) : game_(game) {}
-    virtual bool match(const http::request<http::string_body> &request) = 0;
-    virtual util::Response handle(const http::request<http::string_body> &request) = 0;
+    using Request = http::request<http::string_body>;
+
+    // Receives the response of the endpoint, possibly later and on the strand of a game session.
+    // Also lends the body buffer of the connection to endpoints that serialize large responses.
+    class Respond {
+      public:
+        template <typename Fn>
+            requires(!std::is_same_v<std::decay_t<Fn>, Respond>)
+        Respond(Fn &&fn, util::BodyBuffer buffer = nullptr)
+            : fn_(std::forward<Fn>(fn)), buffer_(std::move(buffer)) {}
+
+        void operator()(util::Response &&response) { fn_(std::move(response)); }
+
+        // Empty buffer for the body: the one of the connection, or a new one if there is none
+        util::BodyBuffer TakeBuffer() {
+            if (!buffer_) {
+                return std::make_shared<std::string>();
+            }
+            buffer_->clear();
+            return std::move(buffer_);
+        }
+
+      private:
+        std::function<void(util::Response &&)> fn_;
+        util::BodyBuffer buffer_;
+    };
+
+    Endpoint(model::Game &game, api_handler::Strands &strands) : game_(game), strands_(strands) {}
+    virtual ~Endpoint() = default;
+
+    // Called by the router for requests to the route of the endpoint with an allowed method
+    virtual void handle(const Request &request, Respond &&respond) = 0;
 
   protected:
+    static constexpr std::string_view MSGPACK_CONTENT_TYPE = "application/x-msgpack";
+
+    // Value of a parameter of the query string, nullopt if there is no such parameter. Values are not decoded.
+    static std::optional<std::string_view> GetQueryParameter(std::string_view target, std::string_view name) {
+        auto query_start = target.find('?');
+        if (query_start == std::string_view::npos) {
+            return std::nullopt;
+        }
+        for (auto query = target.substr(query_start + 1); !query.empty();) {
+            auto end = std::min(query.find('&'), query.size());
+            auto parameter = query.substr(0, end);
+            query.remove_prefix(std::min(end + 1, query.size()));
+            if (parameter.starts_with(name) && parameter.size() > name.size() && parameter[name.size()] == '=') {
+                return parameter.substr(name.size() + 1);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Token from the "Authorization: Bearer <token>" header, nullopt if it is missing or empty
+    static std::optional<std::string_view> GetBearerToken(const Request &request) {
+        constexpr std::string_view authorization_prefix = "Bearer ";
+        auto it = request.find(http::field::authorization);
+        if (it == request.end() || !it->value().starts_with(authorization_prefix) ||
+            it->value().size() == authorization_prefix.size()) {
+            return std::nullopt;
+        }
+        return it->value().substr(authorization_prefix.size());
+    }
+
+    // Clients that list MessagePack in Accept get it instead of JSON
+    static bool AcceptsMsgPack(const Request &request) {
+        return request[http::field::accept].find(MSGPACK_CONTENT_TYPE) != std::string_view::npos;
+    }
+
+    // Successful response written straight into the buffer in the encoding the client asked for. Both encodings
+    // are served from the same URL, so caches are told to keep them apart.
+    template <typename Body>
+    static util::Response Encoded(const Body &body, bool msgpack, util::BodyBuffer buffer) {
+        if (msgpack) {
+            util::MsgPackWriter writer{*buffer};
+            model::api::responses::WriteMsgPack(writer, body);
+        } else {
+            util::JsonWriter writer{*buffer};
+            model::api::responses::WriteJson(writer, body);
+        }
+        auto response = util::Response::Buffer(http::status::ok, msgpack ? MSGPACK_CONTENT_TYPE : "application/json",
+                                               std::move(buffer))
+                            .no_cache();
+        response.set("Vary", "Accept");
+        return response;
+    }
+
+    // Resolve the token on the calling thread, then call fn(session, player) on the strand of the player's session
+    // and respond with its result. The token registry is lock-free, so only the session strand serializes requests.
+    template <typename Fn>
+    void WithPlayer(std::string_view token, Respond &&respond, Fn &&fn) {
+        auto ref = game_.FindPlayerByToken(token);
+        if (!ref) {
+            return respond(model::api::errors::no_user_found());
+        }
+
+        net::dispatch(strands_.Session(ref->session->GetMap().GetId()),
+                      [ref = *ref, respond = std::move(respond), fn = std::forward<Fn>(fn)]() mutable {
+                          auto player = ref.session->FindPlayer(ref.id);
+                          if (!player) {
+                              return respond(model::api::errors::no_user_found());
+                          }
+                          respond(fn(*ref.session, *player));
+                      });
+    }
+
     model::Game &game_;
+    api_handler::Strands &strands_;
 };
\ No newline at end of file
@@ -1,20 +1,35 @@
 #include "endpoint.hpp"
 
+#include "api_handler/router.hpp"
 #include "fallthrough.hpp"
 #include "game/join.hpp"
-// #include "game/player/action.hpp"
+#include "game/player/action.hpp"
 #include "game/player/get_players.hpp"
-// #include "game/state/get_state.hpp"
+#include "game/state/get_state.hpp"
 // #include "game/tick.hpp"
 #include "map/get_map.hpp"
 #include "map/get_maps.hpp"
 #include <memory>
 
-inline std::vector<std::shared_ptr<Endpoint>> GetEndpoints(model::Game &game) {
-    return {std::shared_ptr<Endpoint>{new GetMapEndpoint{game}}, std::shared_ptr<Endpoint>{new GetMapsEndpoint{game}},
-            std::shared_ptr<Endpoint>{new JoinEndpoint{game}}, std::shared_ptr<Endpoint>{new GetPlayersEndpoint(game)},
-            // std::shared_ptr<Endpoint>{new GetStateEndpoint(game)},
-            // std::shared_ptr<Endpoint>{new ActionEndpoint{game}},
-            // std::shared_ptr<Endpoint>{new TickEndpoint(game)},
-            std::shared_ptr<Endpoint>{new FallthroughEndpoint(game)}};
+using EndpointRouter = api_handler::Router<std::shared_ptr<Endpoint>>;
+
+// Route table of the API, other methods get 405 from the router before reaching the endpoint
+inline EndpointRouter GetEndpoints(model::Game &game, api_handler::Strands &strands) {
+    constexpr auto get = api_handler::MethodsOf({http::verb::get, http::verb::head});
+    constexpr auto post = api_handler::MethodsOf({http::verb::post});
+    constexpr auto any = ~api_handler::Methods{0};
+
+    EndpointRouter router;
+    router.Add("/api/v1/maps", get, std::shared_ptr<Endpoint>{new GetMapsEndpoint{game, strands}});
+    std::shared_ptr<Endpoint> get_map{new GetMapEndpoint{game, strands}};
+    router.Add("/api/v1/maps/{id}", get, get_map);
+    // Anything under a map is an unknown map, not an unknown endpoint
+    router.Add("/api/v1/maps/{id}/*", get, get_map);
+    router.Add("/api/v1/game/join", post, std::shared_ptr<Endpoint>{new JoinEndpoint{game, strands}});
+    router.Add("/api/v1/game/players", get, std::shared_ptr<Endpoint>{new GetPlayersEndpoint(game, strands)});
+    router.Add("/api/v1/game/state", get, std::shared_ptr<Endpoint>{new GetStateEndpoint(game, strands)});
+    router.Add("/api/v1/game/player/action", post, std::shared_ptr<Endpoint>{new ActionEndpoint{game, strands}});
+    // router.Add("/api/v1/game/tick", post, std::shared_ptr<Endpoint>{new TickEndpoint(game)});
+    router.Add("/api/*", any, std::shared_ptr<Endpoint>{new FallthroughEndpoint(game, strands)});
+    return router;
 }
\ No newline at end of file
@@ -5,10 +5,7 @@
 class FallthroughEndpoint : public Endpoint {
   public:
     using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override {
-        return request.target().starts_with("/api/");
-    }
-    util::Response handle(const http::request<http::string_body> &request) override {
-        return model::api::errors::invalid_endpoint();
+    void handle(const Request &request, Respond &&respond) override {
+        respond(model::api::errors::invalid_endpoint());
     }
 };
\ No newline at end of file
@@ -6,45 +6,45 @@
 class JoinEndpoint : public Endpoint {
   public:
     using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override {
-        if (request.method() != http::verb::post) {
-            return model::api::errors::only_post();
-        }
-
+    void handle(const Request &request, Respond &&respond) override {
+        model::api::requests::JoinRequest join_request;
         try {
-            auto [username, map_ident] =
-                value_to<model::api::requests::JoinRequest>(boost::json::parse(request.body()));
-            return execute(std::move(username), model::Map::Id{std::move(map_ident)});
+            join_request = value_to<model::api::requests::JoinRequest>(boost::json::parse(request.body()));
         } catch (...) {
-            return model::api::errors::parse_error();
+            return respond(model::api::errors::parse_error());
         }
+        execute(std::move(join_request.userName), model::Map::Id{std::move(join_request.mapId)}, std::move(respond));
     }
-    util::Response execute(std::string username, model::Map::Id map_ident) {
+    void execute(std::string username, model::Map::Id map_ident, Respond &&respond) {
         if (username.empty()) {
-            return model::api::errors::invalid_username();
+            return respond(model::api::errors::invalid_username());
+        } else if (!game_.ContainsMap(map_ident)) {
+            return respond(model::api::errors::map_not_found());
         }
 
-        if (!game_.ContainsSession(map_ident)) {
-            if (!game_.ContainsMap(map_ident)) {
-                return model::api::errors::map_not_found();
+        // Sessions and tokens are created on the global strand, the dog is added on the strand of its session
+        net::dispatch(strands_.Global(), [this, username = std::move(username), map_ident = std::move(map_ident),
+                                          respond = std::move(respond)]() mutable {
+            if (!game_.ContainsSession(map_ident)) {
+                game_.AddSession(game_.GetMap(map_ident));
             }
-            auto &map = game_.GetMap(map_ident);
-            game_.AddSession(model::GameSession(map));
-        }
 
-        auto &session = game_.GetSession(map_ident);
-        auto [player, token] = game_.AddPlayer(std::move(username), session);
-        return responses::ok(player, token);
+            auto &session = game_.GetSession(map_ident);
+            auto [id, token] = game_.AddPlayerToken(session);
+            net::dispatch(strands_.Session(map_ident), [this, &session, id, token, username = std::move(username),
+                                                        respond = std::move(respond)]() mutable {
+                session.AddPlayer(id, std::move(username), game_.GetRandomizeSpawnPoints());
+                respond(responses::ok(id, token));
+            });
+        });
     }
 
   private:
     struct responses {
-        static util::Response ok(const std::shared_ptr<model::Player> player, const model::Token &token) {
+        static util::Response ok(model::Player::Id id, const model::Token &token) {
             return util::Response::Json(http::status::ok, json::value_from(model::api::responses::JoinResponse{
-                                                              .authToken = token, .playerId = player->GetId()}))
+                                                              .authToken = token, .playerId = id}))
                 .no_cache();
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/game/join"};
 };
\ No newline at end of file
@@ -6,38 +6,27 @@
 class GetPlayersEndpoint : public Endpoint {
   public:
     using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override {
-        auto method = request.method();
-
-        // TODO: Пустой токен засчитывается за валидный, исправить
-        std::string_view authorization_prefix = "Bearer ";
-        if (!request.count("Authorization") || !request["Authorization"].starts_with(authorization_prefix)) {
-            return model::api::errors::no_token();
-        } else if (method != http::verb::get && method != http::verb::head) {
-            return model::api::errors::only_get_and_head();
-        } else {
-            std::string_view token = request["Authorization"];
-            token.remove_prefix(authorization_prefix.size());
-            return execute(token);
+    void handle(const Request &request, Respond &&respond) override {
+        auto token = GetBearerToken(request);
+        if (!token) {
+            return respond(model::api::errors::no_token());
         }
+        execute(*token, AcceptsMsgPack(request), std::move(respond));
     }
-    util::Response execute(std::string_view token) {
-        auto player = game_.GetPlayer(token);
-        if (!player) {
-            return model::api::errors::no_user_found();
-        }
-        const auto &players = game_.GetPlayers(player->GetSession().GetMap().GetId());
-        return responses::ok(players);
+    void execute(std::string_view token, bool msgpack, Respond &&respond) {
+        // Serialized on the session strand straight into the buffer of the connection
+        auto buffer = respond.TakeBuffer();
+        WithPlayer(token, std::move(respond),
+                   [buffer = std::move(buffer), msgpack](const model::GameSession &session,
+                                                         const model::Player &) mutable {
+                       return responses::ok(session.GetPlayers(), msgpack, std::move(buffer));
+                   });
     }
 
   private:
     struct responses {
-        static util::Response ok(const std::unordered_map<model::Player::Id, std::shared_ptr<model::Player>> &players) {
-            return util::Response::Json(http::status::ok,
-                                        json::value_from(model::api::responses::GetPlayersResponse{.players = players}))
-                .no_cache();
+        static util::Response ok(const model::GameSession::Players &players, bool msgpack, util::BodyBuffer buffer) {
+            return Encoded(model::api::responses::GetPlayersResponse{.players = players}, msgpack, std::move(buffer));
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/game/players"};
 };
\ No newline at end of file
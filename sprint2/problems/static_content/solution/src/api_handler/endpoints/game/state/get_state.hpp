@@ -2,38 +2,53 @@
 
 #include "api_handler/endpoints/endpoint.hpp"
 
+#include <charconv>
+
 class GetStateEndpoint : public Endpoint {
   public:
     using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override {
-        auto method = request.method();
+    void handle(const Request &request, Respond &&respond) override {
+        auto token = GetBearerToken(request);
+        if (!token) {
+            return respond(model::api::errors::no_token());
+        }
 
-        // TODO: Пустой токен засчитывается за валидный, исправить
-        if (!request.count("Authorization") || !request["Authorization"].starts_with("Authorization: Bearer ")) {
-            return model::api::errors::no_token();
-        } else if (method != http::verb::get && method != http::verb::head) {
-            return model::api::errors::only_get_and_head();
-        } else {
-            return execute(request["Authorization"]);
+        // ?since=N asks for the dogs that changed after tick N only
+        std::optional<std::uint64_t> since;
+        if (auto value = GetQueryParameter(request.target(), "since"); value) {
+            std::uint64_t tick = 0;
+            auto [end, ec] = std::from_chars(value->data(), value->data() + value->size(), tick);
+            if (ec != std::errc{} || end != value->data() + value->size()) {
+                return respond(model::api::errors::invalid_query());
+            }
+            since = tick;
         }
+        execute(*token, since, AcceptsMsgPack(request), std::move(respond));
     }
-    util::Response execute(std::string token) {
-        auto player = game_.GetPlayer(token);
-        if (!player) {
-            return model::api::errors::no_user_found();
-        }
-        const auto &players = game_.GetPlayers(player->GetSession()->GetMap()->GetId());
-        return responses::ok(players);
+    void execute(std::string_view token, std::optional<std::uint64_t> since, bool msgpack, Respond &&respond) {
+        // Serialized on the session strand straight into the buffer of the connection
+        auto buffer = respond.TakeBuffer();
+        WithPlayer(token, std::move(respond),
+                   [buffer = std::move(buffer), since, msgpack](const model::GameSession &session,
+                                                                const model::Player &) mutable {
+                       if (since) {
+                           return responses::delta(session.GetPlayers(), *since, session.GetTick(), msgpack,
+                                                   std::move(buffer));
+                       }
+                       return responses::ok(session.GetPlayers(), msgpack, std::move(buffer));
+                   });
     }
 
   private:
     struct responses {
-        static util::Response ok(const std::unordered_map<model::Player::Id, std::shared_ptr<model::Player>> &players) {
-            return util::Response::Json(http::status::ok,
-                                        json::value_from(model::api::responses::GetStateResponse{players}))
-                .no_cache();
+        static util::Response ok(const model::GameSession::Players &players, bool msgpack, util::BodyBuffer buffer) {
+            return Encoded(model::api::responses::GetStateResponse{players}, msgpack, std::move(buffer));
+        }
+
+        static util::Response delta(const model::GameSession::Players &players, std::uint64_t since,
+                                    std::uint64_t tick, bool msgpack, util::BodyBuffer buffer) {
+            return Encoded(model::api::responses::GetStateDeltaResponse{players, since, tick}, msgpack,
+                           std::move(buffer));
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/game/state"};
 };
\ No newline at end of file
@@ -2,29 +2,43 @@
 
 #include "api_handler/endpoints/endpoint.hpp"
 #include "model/domains/api.hpp"
+#include "util/etag.hpp"
+#include "util/string_hash.hpp"
+
+#include <unordered_map>
 
 class GetMapEndpoint : public Endpoint {
   public:
-    using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override {
-        return request.target().starts_with(endpoint) && !request.target().ends_with(endpoint);
-    }
-    util::Response handle(const http::request<http::string_body> &request) override {
-        std::string_view map_ident = request.target().substr(endpoint.size());
-        return execute(model::Map::Id{std::string{map_ident}});
+    // Every map is serialized once at startup, lookups by the id from the target do not allocate
+    GetMapEndpoint(model::Game &game, api_handler::Strands &strands) : Endpoint(game, strands) {
+        for (const auto &map : game_.GetMaps()) {
+            maps_.emplace(*map.GetId(), util::CachedBody::Json(json::value_from(map)));
+        }
     }
-    util::Response execute(model::Map::Id map_ident) {
-        if (!game_.ContainsMap(map_ident))
-            return model::api::errors::map_not_found();
-        else
-            return responses::ok(game_.GetMap(map_ident));
+
+    void handle(const Request &request, Respond &&respond) override {
+        // The map id is the rest of the target, so "map1/roads" is not found like any other unknown map
+        std::string_view target = request.target();
+        target = target.substr(0, target.find('?'));
+        std::string_view map_ident = target.substr(endpoint.size());
+
+        auto it = maps_.find(map_ident);
+        if (it == maps_.end()) {
+            return respond(model::api::errors::map_not_found());
+        }
+        if (util::ETagMatches(request[http::field::if_none_match], it->second.etag)) {
+            return respond(util::Response::NotModified(it->second.etag));
+        }
+        respond(responses::ok(it->second));
     }
 
   private:
     struct responses {
-        static util::Response ok(const model::Map &map) {
-            return util::Response::Json(http::status::ok, json::value_from(map));
+        static util::Response ok(const util::CachedBody &map) {
+            return util::Response::Cached(http::status::ok, "application/json", map);
         }
     };
+
     static constexpr std::string_view endpoint{"/api/v1/maps/"};
+    std::unordered_map<std::string, util::CachedBody, string_hash, std::equal_to<>> maps_;
 };
\ No newline at end of file
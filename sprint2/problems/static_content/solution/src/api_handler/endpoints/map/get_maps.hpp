@@ -1,18 +1,27 @@
 #pragma once
 
 #include "api_handler/endpoints/endpoint.hpp"
+#include "util/etag.hpp"
 
 class GetMapsEndpoint : public Endpoint {
   public:
-    using Endpoint::Endpoint;
-    bool match(const http::request<http::string_body> &request) override { return request.target() == endpoint; }
-    util::Response handle(const http::request<http::string_body> &request) override { return responses::ok(game_); }
+    // Maps never change after startup, so the list is serialized once and every request shares the buffer
+    GetMapsEndpoint(model::Game &game, api_handler::Strands &strands)
+        : Endpoint(game, strands), maps_(util::CachedBody::Json(json::value_from(game_.GetMaps()))) {}
+
+    void handle(const Request &request, Respond &&respond) override {
+        if (util::ETagMatches(request[http::field::if_none_match], maps_.etag)) {
+            return respond(util::Response::NotModified(maps_.etag));
+        }
+        respond(responses::ok(maps_));
+    }
 
   private:
     struct responses {
-        static util::Response ok(model::Game &game_) {
-            return util::Response::Json(http::status::ok, json::value_from(game_.GetMaps()));
+        static util::Response ok(const util::CachedBody &maps) {
+            return util::Response::Cached(http::status::ok, "application/json", maps);
         }
     };
-    static constexpr std::string_view endpoint{"/api/v1/maps"};
+
+    util::CachedBody maps_;
 };
\ No newline at end of file
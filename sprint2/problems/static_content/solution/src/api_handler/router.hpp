@@ -0,0 +1,245 @@
+#pragma once
+
+#include <boost/beast/http/verb.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace api_handler {
+
+// Set of HTTP methods as a bit mask
+using Methods = std::uint64_t;
+
+constexpr Methods MethodsOf(std::initializer_list<boost::beast::http::verb> verbs) {
+    Methods methods = 0;
+    for (auto verb : verbs) {
+        methods |= Methods{1} << static_cast<unsigned>(verb);
+    }
+    return methods;
+}
+
+constexpr bool Allows(Methods methods, boost::beast::http::verb verb) {
+    return methods & (Methods{1} << static_cast<unsigned>(verb));
+}
+
+// Route table over request targets. Patterns are split by '/', a "{name}" segment matches any non-empty segment
+// and a trailing "*" segment matches any rest of the target. Routes without parameters are found with a single
+// probe of a hash table keyed by the whole path, the others by walking a segment trie once over the target,
+// so the cost does not depend on the number of routes.
+template <typename Target>
+class Router {
+  public:
+    struct Match {
+        const Target *target = nullptr;
+        Methods allowed = 0;
+        // Pattern of the matched route as it was added, such as "/api/v1/maps/{id}"
+        std::string_view pattern;
+
+        bool MethodAllowed(boost::beast::http::verb verb) const { return Allows(allowed, verb); }
+    };
+
+    Router() : nodes_(1) {}
+
+    void Add(std::string_view pattern, Methods methods, Target target) {
+        if (pattern.find_first_of("{*") == std::string_view::npos) {
+            if (exact_.FindChild(pattern) != NONE) {
+                throw std::invalid_argument{"duplicate route"};
+            }
+            exact_.AddChild(pattern, AddRoute(pattern, methods, std::move(target)));
+            return;
+        }
+
+        NodeIndex node = ROOT;
+        for (auto rest = pattern; !rest.empty();) {
+            auto segment = NextSegment(rest);
+            if (segment == "*") {
+                if (!rest.empty()) {
+                    throw std::invalid_argument{"catch-all must be the last segment of a route"};
+                }
+                if (nodes_[node].catch_all != NONE) {
+                    throw std::invalid_argument{"duplicate route"};
+                }
+                nodes_[node].catch_all = AddRoute(pattern, methods, std::move(target));
+                return;
+            }
+
+            if (segment.starts_with('{') && segment.ends_with('}')) {
+                if (nodes_[node].param_child == NONE) {
+                    auto child = AddNode();
+                    nodes_[node].param_child = child;
+                }
+                node = nodes_[node].param_child;
+            } else if (auto child = nodes_[node].FindChild(segment); child != NONE) {
+                node = child;
+            } else {
+                child = AddNode();
+                nodes_[node].AddChild(segment, child);
+                node = child;
+            }
+        }
+        if (nodes_[node].route != NONE) {
+            throw std::invalid_argument{"duplicate route"};
+        }
+        nodes_[node].route = AddRoute(pattern, methods, std::move(target));
+    }
+
+    // Patterns of all routes in the order they were added
+    std::vector<std::string_view> Patterns() const {
+        std::vector<std::string_view> patterns;
+        for (const auto &route : routes_) {
+            patterns.push_back(route.pattern);
+        }
+        return patterns;
+    }
+
+    // Exact routes win over parameters, and the deepest catch-all passed on the way is the fallback.
+    // The query string is not part of the route.
+    Match Find(std::string_view target) const {
+        target = target.substr(0, target.find('?'));
+        if (auto route = exact_.FindChild(target); route != NONE) {
+            return MatchOf(route);
+        }
+
+        const auto size = target.size();
+        NodeIndex node = ROOT;
+        RouteIndex fallback = NONE;
+        for (std::size_t pos = 0; node != NONE && pos < size && target[pos] == '/';) {
+            const auto &current = nodes_[node];
+            if (current.catch_all != NONE) {
+                fallback = current.catch_all;
+            }
+
+            const auto begin = ++pos;
+            while (pos < size && target[pos] != '/') {
+                ++pos;
+            }
+            const auto segment = target.substr(begin, pos - begin);
+
+            if (auto child = current.FindChild(segment); child != NONE) {
+                node = child;
+            } else if (!segment.empty()) {
+                node = current.param_child;
+            } else {
+                node = NONE;
+            }
+        }
+
+        RouteIndex route = node != NONE && nodes_[node].route != NONE ? nodes_[node].route : fallback;
+        if (route == NONE) {
+            return {};
+        }
+        return MatchOf(route);
+    }
+
+  private:
+    using NodeIndex = std::uint32_t;
+    using RouteIndex = std::uint32_t;
+
+    static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+    static constexpr NodeIndex ROOT = 0;
+
+    struct Route {
+        std::string pattern;
+        Methods methods;
+        Target target;
+    };
+
+    // Child of a trie node, or a route in the table of exact routes
+    struct Child {
+        std::string segment;
+        std::uint32_t node = NONE;
+    };
+
+    struct Node {
+        // Linear probing over a power of two table kept at most half full
+        NodeIndex FindChild(std::string_view segment) const noexcept {
+            if (children.empty()) {
+                return NONE;
+            }
+            const auto mask = children.size() - 1;
+            for (auto i = Hash(segment) & mask;; i = (i + 1) & mask) {
+                const auto &child = children[i];
+                if (child.node == NONE || child.segment == segment) {
+                    return child.node;
+                }
+            }
+        }
+
+        void AddChild(std::string_view segment, NodeIndex node) {
+            if ((child_count + 1) * 2 > children.size()) {
+                std::vector<Child> old(std::max<std::size_t>(4, children.size() * 2));
+                old.swap(children);
+                for (auto &child : old) {
+                    if (child.node != NONE) {
+                        Place(std::move(child));
+                    }
+                }
+            }
+            Place(Child{std::string{segment}, node});
+            ++child_count;
+        }
+
+        void Place(Child &&child) {
+            const auto mask = children.size() - 1;
+            auto i = Hash(child.segment) & mask;
+            while (children[i].node != NONE) {
+                i = (i + 1) & mask;
+            }
+            children[i] = std::move(child);
+        }
+
+        std::vector<Child> children;
+        std::size_t child_count = 0;
+        NodeIndex param_child = NONE;
+        RouteIndex route = NONE;
+        RouteIndex catch_all = NONE;
+    };
+
+    // Hashes only the length and the last two characters: routes and segments differ there almost always,
+    // and probing compares whole keys anyway
+    static std::size_t Hash(std::string_view key) noexcept {
+        if (key.size() < 2) {
+            return key.size() * 0x9E3779B1u;
+        }
+        return key.size() * 0x9E3779B1u ^ static_cast<unsigned char>(key[key.size() - 2]) * 0x85EBCA77u ^
+               static_cast<unsigned char>(key.back()) * 0xC2B2AE3Du;
+    }
+
+    // Cut the next segment off a "/a/b" style pattern
+    static std::string_view NextSegment(std::string_view &rest) {
+        if (rest.starts_with('/')) {
+            rest.remove_prefix(1);
+        }
+        auto end = std::min(rest.find('/'), rest.size());
+        auto segment = rest.substr(0, end);
+        rest.remove_prefix(end);
+        return segment;
+    }
+
+    NodeIndex AddNode() {
+        nodes_.emplace_back();
+        return static_cast<NodeIndex>(nodes_.size() - 1);
+    }
+
+    RouteIndex AddRoute(std::string_view pattern, Methods methods, Target &&target) {
+        routes_.push_back(Route{std::string{pattern}, methods, std::move(target)});
+        return static_cast<RouteIndex>(routes_.size() - 1);
+    }
+
+    Match MatchOf(RouteIndex route) const {
+        const auto &found = routes_[route];
+        return {&found.target, found.methods, found.pattern};
+    }
+
+    Node exact_;
+    std::vector<Node> nodes_;
+    std::vector<Route> routes_;
+};
+
+} // namespace api_handler
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "model/model.hpp"
+#include "util/json_writer.hpp"
+#include "util/shared_body.hpp"
+
+namespace api_handler {
+
+// Pushes the state of a game session to the players subscribed to it after every tick. A message is serialized
+// once per tick and shared by all subscribers of the session: the dogs changed by the tick, or the full state
+// for those that have just subscribed or lost messages. Subscribers of a session are only touched on its strand,
+// and the set of maps is fixed at startup, so nothing is locked.
+class StateFeed {
+  public:
+    using Message = util::SharedBody::value_type;
+
+    class Subscriber {
+      public:
+        virtual ~Subscriber() = default;
+
+        // A full message replaces every message before it. False once the subscriber is gone.
+        virtual bool Push(const Message &message, bool full) = 0;
+        // True if messages were lost since the last call, the subscriber gets the full state then
+        virtual bool TakeLagged() = 0;
+    };
+
+    explicit StateFeed(const model::Game::Maps &maps) {
+        for (const auto &map : maps) {
+            subscribers_[map.GetId()];
+        }
+    }
+
+    StateFeed(const StateFeed &) = delete;
+    StateFeed &operator=(const StateFeed &) = delete;
+
+    // On the strand of the session. The subscriber gets the full state right away.
+    void Subscribe(const model::GameSession &session, std::shared_ptr<Subscriber> subscriber) {
+        if (subscriber->Push(Serialize(session, FULL), true)) {
+            subscribers_.at(session.GetMap().GetId()).push_back(std::move(subscriber));
+        }
+    }
+
+    // On the strand of the session, after its tick or the given number of ticks run one after another
+    void Publish(const model::GameSession &session, std::uint64_t ticks = 1) {
+        auto &subscribers = subscribers_.at(session.GetMap().GetId());
+        if (subscribers.empty()) {
+            return;
+        }
+        Message delta;
+        Message full;
+        std::erase_if(subscribers, [&](const std::shared_ptr<Subscriber> &subscriber) {
+            if (subscriber->TakeLagged()) {
+                if (!full) {
+                    full = Serialize(session, FULL);
+                }
+                return !subscriber->Push(full, true);
+            }
+            if (!delta) {
+                delta = Serialize(session, session.GetTick() - ticks);
+            }
+            return !subscriber->Push(delta, false);
+        });
+    }
+
+    std::size_t Subscribers(const model::Map::Id &map_id) const { return subscribers_.at(map_id).size(); }
+
+  private:
+    // Any tick is before this one, so every dog is written
+    static constexpr std::uint64_t FULL = std::numeric_limits<std::uint64_t>::max();
+
+    static Message Serialize(const model::GameSession &session, std::uint64_t since) {
+        auto message = std::make_shared<std::string>();
+        util::JsonWriter writer{*message};
+        model::api::responses::WriteJson(
+            writer, model::api::responses::GetStateDeltaResponse{session.GetPlayers(), since, session.GetTick()});
+        return message;
+    }
+
+    std::unordered_map<model::Map::Id, std::vector<std::shared_ptr<Subscriber>>> subscribers_;
+};
+
+} // namespace api_handler
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <unordered_map>
+
+#include "model/model.hpp"
+
+namespace api_handler {
+
+namespace net = boost::asio;
+
+// Serial executors of the game: one strand per map for the session played on it, and a global strand
+// that only creates sessions and issues tokens. The set of maps is fixed at startup, so lookups need no locking.
+class Strands {
+  public:
+    using Strand = net::strand<net::io_context::executor_type>;
+
+    Strands(net::io_context &ioc, const model::Game::Maps &maps) : global_(net::make_strand(ioc)) {
+        for (const auto &map : maps) {
+            sessions_.emplace(map.GetId(), net::make_strand(ioc));
+        }
+    }
+
+    Strands(const Strands &) = delete;
+    Strands &operator=(const Strands &) = delete;
+
+    Strand &Global() noexcept { return global_; }
+
+    // Strand of the session played on the map
+    Strand &Session(const model::Map::Id &map_id) { return sessions_.at(map_id); }
+
+  private:
+    Strand global_;
+    std::unordered_map<model::Map::Id, Strand> sessions_;
+};
+
+} // namespace api_handler
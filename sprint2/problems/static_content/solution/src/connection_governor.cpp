@@ -0,0 +1,70 @@
+#include "connection_governor.hpp"
+
+namespace http_server {
+
+ConnectionGovernor::Ticket &ConnectionGovernor::Ticket::operator=(Ticket &&other) noexcept {
+    if (this != &other) {
+        if (governor_) {
+            governor_->Release(address_);
+        }
+        governor_ = std::move(other.governor_);
+        address_ = std::move(other.address_);
+    }
+    return *this;
+}
+
+ConnectionGovernor::Ticket::~Ticket() {
+    if (governor_) {
+        governor_->Release(address_);
+    }
+}
+
+ConnectionGovernor::Ticket ConnectionGovernor::Admit(const boost::asio::ip::address &address) {
+    auto key = address.to_string();
+    std::lock_guard lock{mutex_};
+    // Several listeners may accept at once, so the total is checked here too
+    if (connections_ >= limits_.max_connections) {
+        return {};
+    }
+    auto &count = per_address_[key];
+    if (count >= limits_.max_connections_per_ip) {
+        return {};
+    }
+    ++count;
+    ++connections_;
+    return Ticket{shared_from_this(), std::move(key)};
+}
+
+void ConnectionGovernor::WhenAvailable(std::function<void()> fn) {
+    {
+        std::lock_guard lock{mutex_};
+        if (connections_ >= limits_.max_connections) {
+            waiting_.push_back(std::move(fn));
+            return;
+        }
+    }
+    fn();
+}
+
+std::size_t ConnectionGovernor::Connections() const {
+    std::lock_guard lock{mutex_};
+    return connections_;
+}
+
+void ConnectionGovernor::Release(const std::string &address) {
+    std::vector<std::function<void()>> resumed;
+    {
+        std::lock_guard lock{mutex_};
+        --connections_;
+        if (auto it = per_address_.find(address); it != per_address_.end() && --it->second == 0) {
+            per_address_.erase(it);
+        }
+        resumed.swap(waiting_);
+    }
+    // Called without the lock, a resumed listener may be admitted again right away
+    for (auto &fn : resumed) {
+        fn();
+    }
+}
+
+} // namespace http_server
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/asio/ip/address.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/string_hash.hpp"
+
+namespace http_server {
+
+using namespace std::literals;
+
+struct ConnectionLimits {
+    // Sessions open at once. Accepting pauses while there are this many.
+    std::size_t max_connections = 10'000;
+    std::size_t max_connections_per_ip = 256;
+    // Time to receive the header of a request, including the wait for it on a kept-alive connection
+    std::chrono::milliseconds header_timeout = 30s;
+    // Time to receive the body once the header has been read
+    std::chrono::milliseconds body_timeout = 30s;
+    // Larger bodies are refused with 413 by the parser
+    std::uint64_t max_body_size = 1024 * 1024;
+};
+
+// Keeps count of the open sessions, in total and per client address, for every listener of the server.
+// Thread-safe: sessions end on any thread.
+class ConnectionGovernor : public std::enable_shared_from_this<ConnectionGovernor> {
+  public:
+    // Admission of one session, given back when it is destroyed
+    class Ticket {
+      public:
+        Ticket() = default;
+        Ticket(Ticket &&other) noexcept = default;
+        Ticket &operator=(Ticket &&other) noexcept;
+        ~Ticket();
+
+        explicit operator bool() const { return governor_ != nullptr; }
+
+      private:
+        friend class ConnectionGovernor;
+
+        Ticket(std::shared_ptr<ConnectionGovernor> governor, std::string address)
+            : governor_(std::move(governor)), address_(std::move(address)) {}
+
+        std::shared_ptr<ConnectionGovernor> governor_;
+        std::string address_;
+    };
+
+    explicit ConnectionGovernor(ConnectionLimits limits) : limits_(limits) {}
+
+    ConnectionGovernor(const ConnectionGovernor &) = delete;
+    ConnectionGovernor &operator=(const ConnectionGovernor &) = delete;
+
+    const ConnectionLimits &Limits() const { return limits_; }
+
+    // Empty ticket if the server or the address already has as many sessions as allowed
+    Ticket Admit(const boost::asio::ip::address &address);
+
+    // Call fn as soon as a session can be admitted: right away, or when one of the open sessions ends
+    void WhenAvailable(std::function<void()> fn);
+
+    std::size_t Connections() const;
+
+  private:
+    void Release(const std::string &address);
+
+    const ConnectionLimits limits_;
+    mutable std::mutex mutex_;
+    std::size_t connections_ = 0;
+    std::unordered_map<std::string, std::size_t, string_hash, std::equal_to<>> per_address_;
+    // Listeners that have paused accepting
+    std::vector<std::function<void()>> waiting_;
+};
+
+} // namespace http_server
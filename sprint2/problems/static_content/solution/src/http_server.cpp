@@ -1,23 +1,79 @@
 #include "http_server.hpp"
 #include "util/logging.hpp"
+#include "util/metrics.hpp"
 
 #include <boost/asio/dispatch.hpp>
 
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+
+#include <cerrno>
+#endif
+
 namespace http_server {
 
 using namespace util;
 
+namespace {
+
+struct ConnectionMetrics {
+    Counter &opened = Metrics().GetCounter("http_connections_total"sv, "HTTP connections accepted"sv);
+    Gauge &active = Metrics().GetGauge("http_connections_active"sv, "HTTP connections open now"sv);
+    Counter &rejected =
+        Metrics().GetCounter("http_requests_rejected_total"sv, "Requests over the size limits of the server"sv);
+    Counter &timeouts =
+        Metrics().GetCounter("http_read_timeouts_total"sv, "Connections closed while waiting for a request"sv);
+    Gauge &websockets = Metrics().GetGauge("websocket_connections_active"sv, "WebSocket connections open now"sv);
+    Counter &dropped = Metrics().GetCounter("websocket_messages_dropped_total"sv,
+                                            "Messages not sent to WebSocket clients that fell behind"sv);
+};
+
+ConnectionMetrics &GetConnectionMetrics() {
+    static ConnectionMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
 void ReportError(beast::error_code ec, std::string_view what) { LogError(ec.value(), ec.message(), what); }
 
+void SetReusePort(tcp::acceptor &acceptor) {
+#ifdef SO_REUSEPORT
+    acceptor.set_option(net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+    throw std::runtime_error{"SO_REUSEPORT is not supported"};
+#endif
+}
+
+SessionBase::SessionBase(tcp::socket &&socket, ConnectionGovernor::Ticket &&ticket, const ConnectionLimits &limits)
+    : stream_(std::move(socket)), ticket_(std::move(ticket)), limits_(limits),
+      body_buffer_(std::make_shared<std::string>()) {
+    auto &metrics = GetConnectionMetrics();
+    metrics.opened.Inc();
+    metrics.active.Add(1);
+}
+
+SessionBase::~SessionBase() { GetConnectionMetrics().active.Add(-1); }
+
 void SessionBase::Read() {
-    using namespace std::literals;
-    // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
-    request_ = {};
-    stream_.expires_after(30s);
-    // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
-    http::async_read(stream_, buffer_, request_,
-                     // По окончании операции будет вызван метод OnRead
-                     beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+    // Reading waits while the client may not get any more responses or the pipeline is full
+    if (reading_ || last_request_ || closed_ || next_request_ - next_response_ >= MAX_PIPELINE) {
+        return;
+    }
+    reading_ = true;
+    reading_header_ = true;
+    // The parser takes the request with the storage of its body and gives it back in OnRead
+    parser_.emplace(std::move(request_));
+    parser_->body_limit(limits_.max_body_size);
+    stream_.expires_never();
+    ArmHeaderTimer();
+    // Считываем заголовок запроса из stream_, используя buffer_ для хранения считанных данных
+    http::async_read_header(stream_, buffer_, *parser_,
+                            beast::bind_front_handler(&SessionBase::OnReadHeader, GetSharedThis()));
 }
 
 void SessionBase::Run() {
@@ -26,33 +82,317 @@ void SessionBase::Run() {
     net::dispatch(stream_.get_executor(), beast::bind_front_handler(&SessionBase::Read, GetSharedThis()));
 }
 
+void SessionBase::ArmHeaderTimer() {
+    if (!reading_header_ || next_request_ != next_response_) {
+        return;
+    }
+    header_timer_.expires_after(limits_.header_timeout);
+    header_timer_.async_wait([self = GetSharedThis(), sequence = next_request_](beast::error_code ec) {
+        if (!ec) {
+            self->OnHeaderTimeout(sequence);
+        }
+    });
+}
+
+void SessionBase::OnHeaderTimeout(std::uint64_t sequence) {
+    // The wait may have completed after the header came or a response became due
+    if (!reading_header_ || sequence != next_request_ || next_request_ != next_response_) {
+        return;
+    }
+    // Nothing is being written, so only the read is cancelled
+    header_timed_out_ = true;
+    beast::error_code ec;
+    stream_.socket().cancel(ec);
+}
+
+void SessionBase::OnReadHeader(beast::error_code ec, std::size_t bytes_read) {
+    reading_header_ = false;
+    header_timer_.cancel();
+    if (ec || parser_->is_done()) {
+        return OnRead(ec, bytes_read);
+    }
+    // Тело запроса читаем со своим таймаутом, по окончании будет вызван метод OnRead
+    stream_.expires_after(limits_.body_timeout);
+    http::async_read(stream_, buffer_, *parser_, beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+}
+
 void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
     using namespace std::literals;
-    if (ec == http::error::end_of_stream) {
-        // Нормальная ситуация - клиент закрыл соединение
-        return Close();
+    reading_ = false;
+    request_ = parser_->release();
+    parser_.reset();
+    if (std::exchange(header_timed_out_, false) && ec == net::error::operation_aborted) {
+        ec = beast::error::timeout;
+    }
+
+    if (ec == http::error::body_limit) {
+        return Reject(http::status::payload_too_large);
+    }
+    if (ec == http::error::header_limit) {
+        return Reject(http::status::request_header_fields_too_large);
     }
     if (ec) {
-        return ReportError(ec, "read"sv);
+        last_request_ = true;
+        if (ec == beast::error::timeout) {
+            GetConnectionMetrics().timeouts.Inc();
+        }
+        // Нормальная ситуация - клиент закрыл соединение или долго не присылал запрос
+        if (ec != http::error::end_of_stream && ec != beast::error::timeout) {
+            ReportError(ec, "read"sv);
+        }
+        // Responses to the requests read so far are still written
+        if (next_request_ == next_response_) {
+            Close();
+        }
+        return;
+    }
+
+    // No requests follow an upgrade, the request stays in request_ for the handshake
+    if (websocket::is_upgrade(request_) && HandleUpgrade(request_, next_request_)) {
+        last_request_ = true;
+        ++next_request_;
+        return;
     }
-    HandleRequest(std::move(request_));
+
+    last_request_ = !request_.keep_alive();
+    HandleRequest(request_, next_request_++);
+
+    // Clearing instead of assigning a new request keeps the capacity of the body for the next request
+    request_.base() = {};
+    request_.body().clear();
+    Read();
+}
+
+void SessionBase::Reject(http::status status) {
+    http::response<http::string_body> response{status, 11};
+    response.set(http::field::content_type, "text/plain");
+    response.body() = http::obsolete_reason(status);
+    response.keep_alive(false);
+    response.prepare_payload();
+    GetConnectionMetrics().rejected.Inc();
+
+    last_request_ = true;
+    Enqueue(next_request_++, std::move(response));
+}
+
+void SessionBase::Upgrade(WebSocketSession::OnOpen &&on_open) {
+    on_upgrade_ = std::move(on_open);
+    WriteNext();
+}
+
+void SessionBase::WriteNext() {
+    if (writing_ || closed_) {
+        return;
+    }
+    // The upgrade request is the last one, so every earlier response has been written
+    if (on_upgrade_ && next_response_ + 1 == next_request_) {
+        closed_ = true;
+        std::make_shared<WebSocketSession>(std::move(stream_), std::move(ticket_))
+            ->Accept(std::move(request_), std::move(on_upgrade_));
+        return;
+    }
+    auto &slot = ready_[next_response_ % MAX_PIPELINE];
+    if (std::holds_alternative<std::monostate>(slot)) {
+        return;
+    }
+
+    writing_ = true;
+    in_flight_ = std::exchange(slot, QueuedResponse{});
+    std::visit(
+        [this](auto &response) {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(response)>, std::monostate>) {
+                Write(response);
+            }
+        },
+        in_flight_);
 }
 
 void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    writing_ = false;
     if (ec) {
+        closed_ = true;
         return ReportError(ec, "write"sv);
     }
 
     if (close) {
         // Семантика ответа требует закрыть соединение
+        closed_ = true;
         return Close();
     }
 
-    // Считываем следующий запрос
-    Read();
+    ++next_response_;
+    if (last_request_ && !reading_ && next_request_ == next_response_) {
+        return Close();
+    }
+    WriteNext();
+    if (reading_) {
+        // The request being read is timed once every response has been written
+        ArmHeaderTimer();
+    } else {
+        // Считываем следующий запрос, если очередь была заполнена
+        Read();
+    }
+}
+
+void SessionBase::Write(http::response<util::SendfileBody> &response) {
+#ifdef __linux__
+    file_offset_ = response.body().offset();
+    file_end_ = file_offset_ + response.body().size();
+    file_serializer_.emplace(response);
+    stream_.expires_never();
+    http::async_write_header(stream_, *file_serializer_,
+                             util::BindHandlerMemory(write_memory_, [self = GetSharedThis()](beast::error_code ec,
+                                                                                             std::size_t) {
+                                 if (ec) {
+                                     return self->OnFileSent(ec);
+                                 }
+                                 self->SendFile();
+                             }));
+#else
+    Write<util::SendfileBody, http::fields>(response);
+#endif
+}
+
+void SessionBase::SendFile() {
+#ifdef __linux__
+    auto &socket = stream_.socket();
+    auto &response = std::get<http::response<util::SendfileBody>>(in_flight_);
+    const int file = response.body().file().native_handle();
+
+    beast::error_code ec;
+    socket.native_non_blocking(true, ec);
+    while (!ec && file_offset_ < file_end_) {
+        auto offset = static_cast<off_t>(file_offset_);
+        auto sent = ::sendfile(socket.native_handle(), file, &offset, file_end_ - file_offset_);
+        file_offset_ = static_cast<std::uint64_t>(offset);
+        if (sent > 0 || (sent < 0 && errno == EINTR)) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Сокет заполнен, продолжим, когда в него снова можно писать
+            return socket.async_wait(tcp::socket::wait_write,
+                                     util::BindHandlerMemory(write_memory_,
+                                                             [self = GetSharedThis()](beast::error_code ec) {
+                                                                 if (ec) {
+                                                                     return self->OnFileSent(ec);
+                                                                 }
+                                                                 self->SendFile();
+                                                             }));
+        }
+        // The file got shorter than its Content-Length, the response cannot be completed
+        ec = sent < 0 ? beast::error_code{errno, sys::system_category()} : http::error::partial_message;
+    }
+    OnFileSent(ec);
+#endif
+}
+
+void SessionBase::OnFileSent(beast::error_code ec) {
+    auto &response = std::get<http::response<util::SendfileBody>>(in_flight_);
+    bool close = response.need_eof();
+    const auto size = response.body().size();
+    file_serializer_.reset();
+    in_flight_ = {};
+    OnWrite(close, ec, ec ? 0 : size);
+}
+
+WebSocketSession::WebSocketSession(beast::tcp_stream &&stream, ConnectionGovernor::Ticket &&ticket)
+    : ws_(std::move(stream)), ticket_(std::move(ticket)) {
+    GetConnectionMetrics().websockets.Add(1);
+}
+
+WebSocketSession::~WebSocketSession() { GetConnectionMetrics().websockets.Add(-1); }
+
+void WebSocketSession::Accept(http::request<http::string_body> &&request, OnOpen on_open) {
+    // The websocket stream keeps the connection alive with pings instead of the timeouts of HTTP requests
+    beast::get_lowest_layer(ws_).expires_never();
+    ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+    request_ = std::move(request);
+    ws_.async_accept(request_, [self = shared_from_this(), on_open = std::move(on_open)](beast::error_code ec) {
+        self->request_ = {};
+        if (ec) {
+            return self->OnClosed(ec, "websocket accept"sv);
+        }
+        self->ws_.text(true);
+        self->Read();
+        on_open(self);
+    });
+}
+
+bool WebSocketSession::Send(Message message, bool restart) {
+    if (closed_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    net::dispatch(ws_.get_executor(), [self = shared_from_this(), message = std::move(message), restart]() mutable {
+        self->Queue(std::move(message), restart);
+    });
+    return true;
+}
+
+void WebSocketSession::Queue(Message &&message, bool restart) {
+    if (closed_) {
+        return;
+    }
+    // The message being written stays at the front of the queue
+    const auto waiting = queue_.begin() + (writing_ ? 1 : 0);
+    if (restart) {
+        // Older messages are not needed after a restart
+        queue_.erase(waiting, queue_.end());
+        dropping_ = false;
+    } else if (dropping_) {
+        GetConnectionMetrics().dropped.Inc();
+        return;
+    } else if (static_cast<std::size_t>(queue_.end() - waiting) >= MAX_QUEUED) {
+        GetConnectionMetrics().dropped.Inc(queue_.end() - waiting + 1);
+        queue_.erase(waiting, queue_.end());
+        dropping_ = true;
+        lagged_ = true;
+        return;
+    }
+    queue_.push_back(std::move(message));
+    WriteNext();
+}
+
+void WebSocketSession::Read() {
+    ws_.async_read(read_buffer_, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+        if (ec) {
+            return self->OnClosed(ec, "websocket read"sv);
+        }
+        self->read_buffer_.clear();
+        self->Read();
+    });
+}
+
+void WebSocketSession::WriteNext() {
+    if (writing_ || queue_.empty() || closed_) {
+        return;
+    }
+    writing_ = true;
+    const auto &message = *queue_.front();
+    ws_.async_write(net::buffer(message), [self = shared_from_this()](beast::error_code ec, std::size_t) {
+        self->writing_ = false;
+        self->queue_.pop_front();
+        if (ec) {
+            return self->OnClosed(ec, "websocket write"sv);
+        }
+        self->WriteNext();
+    });
+}
+
+void WebSocketSession::OnClosed(beast::error_code ec, std::string_view what) {
+    closed_ = true;
+    queue_.erase(queue_.begin() + (writing_ ? 1 : 0), queue_.end());
+    // Нормальная ситуация - клиент закрыл соединение
+    if (ec != websocket::error::closed && ec != net::error::eof && ec != net::error::operation_aborted &&
+        ec != beast::error::timeout) {
+        ReportError(ec, what);
+    }
 }
 
 void SessionBase::Close() {
+    // A timeout has closed the socket already
+    if (!stream_.socket().is_open()) {
+        return;
+    }
     beast::error_code ec;
     stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
     if (ec) {
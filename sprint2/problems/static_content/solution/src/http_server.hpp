@@ -1,10 +1,30 @@
 #pragma once
 
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "connection_governor.hpp"
+#include "util/handler_memory.hpp"
+#include "util/sendfile_body.hpp"
+#include "util/shared_body.hpp"
 
 // Ядро асинхронного HTTP-сервера будет располагаться в пространстве имён http_server
 namespace http_server {
@@ -14,30 +34,116 @@ using tcp = net::ip::tcp;
 namespace beast = boost::beast;
 namespace sys = boost::system;
 namespace http = beast::http;
+namespace websocket = beast::websocket;
 
 using namespace std::literals;
 
 void ReportError(beast::error_code ec, std::string_view what);
 
+// Several acceptors on the same port, the kernel spreads new connections among them
+void SetReusePort(tcp::acceptor &acceptor);
+
+// Connection upgraded to WebSocket, over which the server pushes messages. Messages of the client are read and
+// thrown away, so that pings and the closing handshake are answered. A client that does not keep up does not make
+// the queue grow: messages over the limit are dropped, and only a restart message, one that does not depend on the
+// messages before it, is queued until the sender has been told about the loss with TakeLagged.
+class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
+  public:
+    using Message = util::SharedBody::value_type;
+    using OnOpen = std::function<void(std::shared_ptr<WebSocketSession>)>;
+
+    // Messages waiting behind the one being written
+    static constexpr std::size_t MAX_QUEUED = 4;
+
+    WebSocketSession(beast::tcp_stream &&stream, ConnectionGovernor::Ticket &&ticket);
+    ~WebSocketSession();
+
+    WebSocketSession(const WebSocketSession &) = delete;
+    WebSocketSession &operator=(const WebSocketSession &) = delete;
+
+    // Answer the upgrade request. on_open is called on the executor of the connection once the handshake is done.
+    void Accept(http::request<http::string_body> &&request, OnOpen on_open);
+
+    // May be called from any thread, the message is shared, not copied. False once the connection is closed.
+    bool Send(Message message, bool restart = false);
+
+    // True once after messages have been dropped, the next message should be a restart
+    bool TakeLagged() noexcept { return lagged_.exchange(false, std::memory_order_relaxed); }
+
+  private:
+    void Queue(Message &&message, bool restart);
+    void Read();
+    void WriteNext();
+    void OnClosed(beast::error_code ec, std::string_view what);
+
+    websocket::stream<beast::tcp_stream> ws_;
+    ConnectionGovernor::Ticket ticket_;
+    // The upgrade request, kept until the handshake is answered
+    http::request<http::string_body> request_;
+    beast::flat_buffer read_buffer_;
+
+    // Used on the executor of the connection only
+    std::deque<Message> queue_;
+    bool writing_ = false;
+    // Messages are being dropped until a restart message comes
+    bool dropping_ = false;
+
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> lagged_{false};
+};
+
+// Requests of a connection are read ahead while earlier responses are being prepared or written (HTTP pipelining).
+// Responses may be ready out of order, since API endpoints answer from the strands of game sessions, so each one
+// waits in the slot of its request and they are written in the order of the requests.
 class SessionBase {
   protected:
     using HttpRequest = http::request<http::string_body>;
 
-    explicit SessionBase(tcp::socket &&socket) : stream_(std::move(socket)) {}
-    ~SessionBase() = default;
+    // Requests handled but not answered yet, reading stops when there are this many
+    static constexpr std::size_t MAX_PIPELINE = 8;
+
+    SessionBase(tcp::socket &&socket, ConnectionGovernor::Ticket &&ticket, const ConnectionLimits &limits);
+    ~SessionBase();
 
     void Read();
 
+    // Hand the connection over to a WebSocketSession once the responses before the upgrade request are written.
+    // Called on the executor of the connection.
+    void Upgrade(WebSocketSession::OnOpen &&on_open);
+
+    // Store the response to the request with the given sequence number and write whatever can be written now.
+    // The body must be one of those held by QueuedResponse.
+    template <typename Body, typename Fields>
+    void Enqueue(std::uint64_t sequence, http::response<Body, Fields> &&response) {
+        ready_[sequence % MAX_PIPELINE].template emplace<http::response<Body, Fields>>(std::move(response));
+        WriteNext();
+    }
+
+    // The response stays in in_flight_ until it is written, the handler only holds the session
     template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields> &&response) {
-        // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
-        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                          [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                              self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                          });
+    void Write(http::response<Body, Fields> &response) {
+        // A write started while no read was pending would keep the deadline of the last read
+        stream_.expires_never();
+        http::async_write(stream_, response,
+                          util::BindHandlerMemory(write_memory_, [self = GetSharedThis(), &response](
+                                                                     beast::error_code ec, std::size_t bytes_written) {
+                              // Ответ освобождаем сразу, чтобы body_buffer_ снова был свободен
+                              bool close = response.need_eof();
+                              self->in_flight_ = {};
+                              self->OnWrite(close, ec, bytes_written);
+                          }));
+    }
+
+    // Files are sent with sendfile(2): the header goes through the serializer, the body straight from the page cache
+    void Write(http::response<util::SendfileBody> &response);
+
+    // The buffer is lent to one request at a time. If the body of an earlier response still holds it, the next
+    // request gets a new one.
+    util::BodyBuffer LendBodyBuffer() {
+        if (body_buffer_.use_count() != 1) {
+            body_buffer_ = std::make_shared<std::string>();
+        }
+        return body_buffer_;
     }
 
     // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
@@ -51,35 +157,117 @@ class SessionBase {
     void Run();
 
   private:
+    using QueuedResponse = std::variant<std::monostate, http::response<http::string_body>,
+                                        http::response<util::SendfileBody>, http::response<util::SharedBody>>;
+
+    // Answer a request that could not be read and read no more
+    void Reject(http::status status);
+    void WriteNext();
+    void SendFile();
+    void OnFileSent(beast::error_code ec);
+    // The wait for a header is timed only while no response is due: a client receiving a long response may send
+    // nothing meanwhile, and closing the connection on the timeout would cut the response off
+    void ArmHeaderTimer();
+    void OnHeaderTimeout(std::uint64_t sequence);
+    void OnReadHeader(beast::error_code ec, std::size_t bytes_read);
     void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
     void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
     void Close();
 
-    // Обработку запроса делегируем подклассу
-    virtual void HandleRequest(HttpRequest &&request) = 0;
+    // Обработку запроса делегируем подклассу. The request stays in the session and is reused for the next one,
+    // so it is only valid during the call.
+    virtual void HandleRequest(const HttpRequest &request, std::uint64_t sequence) = 0;
+    // WebSocket upgrade requests, false if the request handler does not take them and the request is handled as an
+    // ordinary one. The request handler either calls Upgrade or responds, after which the connection is closed.
+    virtual bool HandleUpgrade(const HttpRequest &request, std::uint64_t sequence) = 0;
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 
+    ConnectionGovernor::Ticket ticket_;
+    // Owned by the governor, which the ticket keeps alive
+    const ConnectionLimits &limits_;
+
     beast::flat_buffer buffer_;
+    // Keeps the capacity of its body between requests, the parser borrows it while reading
     HttpRequest request_;
+    std::optional<http::request_parser<http::string_body>> parser_;
+    // Buffer for serializing response bodies, lent to the request handler with every request
+    util::BodyBuffer body_buffer_;
+
+    std::array<QueuedResponse, MAX_PIPELINE> ready_;
+    // The response being written. A file response also has the serializer of its header and the part of the file
+    // sendfile has not sent yet.
+    QueuedResponse in_flight_;
+    std::optional<http::response_serializer<util::SendfileBody>> file_serializer_;
+    std::uint64_t file_offset_ = 0;
+    std::uint64_t file_end_ = 0;
+    // Operations of the write chain are allocated here instead of on the heap
+    util::HandlerMemory write_memory_;
+    // Sequence numbers of the next request to read and of the next response to write
+    std::uint64_t next_request_ = 0;
+    std::uint64_t next_response_ = 0;
+    bool reading_ = false;
+    bool reading_header_ = false;
+    bool writing_ = false;
+    // Limits the wait for a header instead of the deadline of stream_, which would close the socket under a response
+    // being written
+    net::steady_timer header_timer_{stream_.get_executor()};
+    // The header timer has cancelled the read
+    bool header_timed_out_ = false;
+    // No more requests are read: the client has closed its side or asked to close the connection
+    bool last_request_ = false;
+    // The connection is closed or broken, nothing is written anymore
+    bool closed_ = false;
+    // Set by Upgrade, the hand-over waits for the responses before the upgrade request
+    WebSocketSession::OnOpen on_upgrade_;
 };
 
 template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
   public:
     template <typename Handler>
-    Session(tcp::socket &&socket, Handler &&request_handler)
-        : SessionBase(std::move(socket)), request_handler_(std::forward<Handler>(request_handler)) {}
+    Session(tcp::socket &&socket, ConnectionGovernor::Ticket &&ticket, const ConnectionLimits &limits,
+            Handler &&request_handler)
+        : SessionBase(std::move(socket), std::move(ticket), limits),
+          request_handler_(std::forward<Handler>(request_handler)) {}
 
   private:
     std::shared_ptr<SessionBase> GetSharedThis() override { return this->shared_from_this(); }
 
-    void HandleRequest(HttpRequest &&request) override {
+    void HandleRequest(const HttpRequest &request, std::uint64_t sequence) override {
+        request_handler_(stream_.socket().remote_endpoint().address().to_string(), request, LendBodyBuffer(),
+                         MakeSend(sequence));
+    }
+
+    // Request handlers that take upgrades are called with one more argument, a function that accepts the upgrade
+    // and takes the callback of the opened WebSocketSession
+    bool HandleUpgrade(const HttpRequest &request, std::uint64_t sequence) override {
+        auto accept = [self = this->shared_from_this()](WebSocketSession::OnOpen on_open) {
+            // Posted, so that the upgrade request is counted by the session before it is accepted
+            net::post(self->stream_.get_executor(),
+                      [self, on_open = std::move(on_open)]() mutable { self->Upgrade(std::move(on_open)); });
+        };
+        using Send = decltype(MakeSend(sequence));
+        if constexpr (std::is_invocable_v<RequestHandler &, std::string, const HttpRequest &, util::BodyBuffer, Send,
+                                          decltype(accept)>) {
+            request_handler_(stream_.socket().remote_endpoint().address().to_string(), request, LendBodyBuffer(),
+                             MakeSend(sequence), std::move(accept));
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    auto MakeSend(std::uint64_t sequence) {
         // Захватываем умный указатель на текущий объект Session в лямбде,
         // чтобы продлить время жизни сессии до вызова лямбды.
         // Используется generic-лямбда функция, способная принять response произвольного типа
-        request_handler_(stream_.socket().remote_endpoint().address().to_string(), std::move(request),
-                         [self = this->shared_from_this()]<typename Body, typename Fields>(
-                             http::response<Body, Fields> &&response) { self->Write(std::move(response)); });
+        return [self = this->shared_from_this(), sequence]<typename Body, typename Fields>(
+                   http::response<Body, Fields> &&response) {
+            // Ответ может прийти со strand игровой сессии, а с сокетом работаем только в его strand
+            net::dispatch(self->stream_.get_executor(), [self, sequence, response = std::move(response)]() mutable {
+                self->Enqueue(sequence, std::move(response));
+            });
+        };
     }
 
     RequestHandler request_handler_;
@@ -89,11 +277,13 @@ template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
   public:
     template <typename Handler>
-    Listener(net::io_context &ioc, const tcp::endpoint &endpoint, Handler &&request_handler)
+    Listener(net::io_context &ioc, const tcp::endpoint &endpoint, std::shared_ptr<ConnectionGovernor> governor,
+             Handler &&request_handler, bool reuse_port = false)
         : ioc_(ioc)
           // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
           ,
-          acceptor_(net::make_strand(ioc)), request_handler_(std::forward<Handler>(request_handler)) {
+          acceptor_(net::make_strand(ioc)), retry_timer_(acceptor_.get_executor()), governor_(std::move(governor)),
+          request_handler_(std::forward<Handler>(request_handler)) {
         // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
         acceptor_.open(endpoint.protocol());
 
@@ -102,6 +292,9 @@ class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
         // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
         // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
         acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (reuse_port) {
+            SetReusePort(acceptor_);
+        }
         // Привязываем acceptor к адресу и порту endpoint
         acceptor_.bind(endpoint);
         // Переводим acceptor в состояние, в котором он способен принимать новые соединения
@@ -112,7 +305,14 @@ class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
     void Run() { DoAccept(); }
 
   private:
+    // Accepting pauses while the server has as many sessions as it may, the governor resumes it
     void DoAccept() {
+        governor_->WhenAvailable([self = this->shared_from_this()] {
+            net::dispatch(self->acceptor_.get_executor(), [self] { self->Accept(); });
+        });
+    }
+
+    void Accept() {
         acceptor_.async_accept(
             // Передаём последовательный исполнитель, в котором будут вызываться обработчики
             // асинхронных операций сокета
@@ -132,31 +332,67 @@ class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
         using namespace std::literals;
 
         if (ec) {
-            return ReportError(ec, "accept"sv);
+            ReportError(ec, "accept"sv);
+            // Out of descriptors or memory: try again a little later instead of spinning or giving up
+            retry_timer_.expires_after(ACCEPT_RETRY_DELAY);
+            return retry_timer_.async_wait([self = this->shared_from_this()](sys::error_code ec) {
+                if (!ec) {
+                    self->DoAccept();
+                }
+            });
         }
 
-        // Асинхронно обрабатываем сессию
-        AsyncRunSession(std::move(socket));
+        // A client over its limit is disconnected right away
+        sys::error_code endpoint_ec;
+        auto remote = socket.remote_endpoint(endpoint_ec);
+        auto ticket = endpoint_ec ? ConnectionGovernor::Ticket{} : governor_->Admit(remote.address());
+        if (ticket) {
+            // Асинхронно обрабатываем сессию
+            AsyncRunSession(std::move(socket), std::move(ticket));
+        } else {
+            socket.close(endpoint_ec);
+        }
 
         // Принимаем новое соединение
         DoAccept();
     }
 
-    void AsyncRunSession(tcp::socket &&socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+    void AsyncRunSession(tcp::socket &&socket, ConnectionGovernor::Ticket &&ticket) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket), std::move(ticket), governor_->Limits(),
+                                                  request_handler_)
+            ->Run();
     }
 
+    static constexpr auto ACCEPT_RETRY_DELAY = 100ms;
+
     net::io_context &ioc_;
     tcp::acceptor acceptor_;
+    net::steady_timer retry_timer_;
+    std::shared_ptr<ConnectionGovernor> governor_;
     RequestHandler request_handler_;
 };
 
 template <typename RequestHandler>
-void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler) {
+void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint, RequestHandler &&handler,
+               ConnectionLimits limits = {}) {
     // При помощи decay_t исключим ссылки из типа RequestHandler,
     // чтобы Listener хранил RequestHandler по значению
     using MyListener = Listener<std::decay_t<RequestHandler>>;
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, std::make_shared<ConnectionGovernor>(limits),
+                                 std::forward<RequestHandler>(handler))
+        ->Run();
+}
+
+// Thread-per-core mode: one listener with SO_REUSEPORT in every io_context, each meant to be run by a thread of its
+// own. Sessions stay in the context that accepted them, the connection limits are shared by all of them.
+template <typename RequestHandler>
+void ServeHttp(const std::vector<net::io_context *> &contexts, const tcp::endpoint &endpoint, RequestHandler &&handler,
+               ConnectionLimits limits = {}) {
+    using MyListener = Listener<std::decay_t<RequestHandler>>;
+    auto governor = std::make_shared<ConnectionGovernor>(limits);
+    for (auto *ioc : contexts) {
+        std::make_shared<MyListener>(*ioc, endpoint, governor, handler, true)->Run();
+    }
 }
 
-} // namespace http_server
\ No newline at end of file
+} // namespace http_server
@@ -1,5 +1,6 @@
 #include "util/sdk.hpp"
 
+#include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/signal_set.hpp>
 #include <boost/asio/strand.hpp>
@@ -11,10 +12,20 @@
 
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "http_server.hpp"
+#include "api_handler/state_feed.hpp"
+#include "api_handler/strands.hpp"
 #include "json_loader.hpp"
 #include "request_handler.hpp"
 #include "util/logging.hpp"
@@ -41,6 +52,16 @@ void RunWorkers(unsigned num_threads, const Fn &fn) {
     fn();
 }
 
+// Привязывает текущий поток к ядру процессора. Там, где это не поддерживается, ничего не делает
+void PinToCore(unsigned core) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
 } // namespace
 
 struct Args {
@@ -48,6 +69,14 @@ struct Args {
     std::string config_file;
     std::string www_root;
     bool randomize_spawn_points{false};
+    http_server::ConnectionLimits connection_limits;
+    // Число io_context с собственным acceptor (SO_REUSEPORT) и потоком, 0 - один acceptor в общем io_context
+    unsigned accept_threads{0};
+    util::LogMode log_mode{util::LogMode::SYNC};
+    util::AsyncLogOptions log_options;
+    util::TickerOptions ticker_options;
+    // Сколько сессий тикает одновременно, 0 - все потоки сервера
+    unsigned tick_threads{0};
 };
 
 [[nodiscard]]
@@ -59,12 +88,40 @@ std::optional<Args> ParseCommandLine(int argc, const char *const argv[]) {
     Args args;
     // clang-format off
     int tick_period;
+    int header_timeout;
+    int body_timeout;
+    std::string log_mode;
+    std::string log_overflow;
+    std::string tick_mode;
+    auto &limits = args.connection_limits;
     desc.add_options()
         ("help,h", "Show help")
         ("tick-period,t", po::value(&tick_period)->value_name("milliseconds"s), "set tick period")
+        ("tick-mode", po::value(&tick_mode)->value_name("variable|fixed"s),
+            "tick by the real time since the last tick (default) or in steps of exactly one tick period")
+        ("max-catch-up-ticks", po::value(&args.ticker_options.max_catch_up)->value_name("count"s),
+            "set max number of fixed ticks run at once after a pause, the rest of the pause is skipped")
+        ("tick-threads", po::value(&args.tick_threads)->value_name("count"s),
+            "max threads ticking game sessions in parallel (default: all server threads)")
         ("config-file,c", po::value(&args.config_file)->value_name("file"), "set config file path")
         ("www-root,w", po::value(&args.www_root)->value_name("dir"), "set static files root")
-        ("randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points), "spawn dogs at random positions");
+        ("randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points), "spawn dogs at random positions")
+        ("max-connections", po::value(&limits.max_connections)->value_name("count"s),
+            "set max number of open connections, accepting pauses at it")
+        ("max-connections-per-ip", po::value(&limits.max_connections_per_ip)->value_name("count"s),
+            "set max number of open connections from one address")
+        ("header-timeout", po::value(&header_timeout)->value_name("milliseconds"s),
+            "set time to wait for a request header, idle keep-alive time included")
+        ("body-timeout", po::value(&body_timeout)->value_name("milliseconds"s), "set time to read a request body")
+        ("max-body-size", po::value(&limits.max_body_size)->value_name("bytes"s), "set max request body size")
+        ("accept-threads", po::value(&args.accept_threads)->value_name("count"s),
+            "accept and serve connections on this many threads pinned to cores, with SO_REUSEPORT")
+        ("log-mode", po::value(&log_mode)->value_name("sync|async|off"s),
+            "write the log on the request threads (default), from a background thread, or not at all")
+        ("log-overflow", po::value(&log_overflow)->value_name("drop|block"s),
+            "when the async log falls behind, drop records (default) or make the request threads wait")
+        ("log-queue-size", po::value(&args.log_options.queue_size)->value_name("records"s),
+            "set size of the async log queue of every thread");
     // clang-format on
 
     // variables_map хранит значения опций после разбора
@@ -82,6 +139,35 @@ std::optional<Args> ParseCommandLine(int argc, const char *const argv[]) {
         args.tick_period = tick_period;
     }
 
+    if (tick_mode == "fixed"sv) {
+        args.ticker_options.mode = util::TickMode::FIXED;
+    } else if (!tick_mode.empty() && tick_mode != "variable"sv) {
+        throw std::runtime_error{"Unknown tick mode "s + tick_mode};
+    }
+    if (args.ticker_options.max_catch_up == 0) {
+        throw std::runtime_error{"max-catch-up-ticks must be positive"s};
+    }
+
+    if (vm.contains("header-timeout")) {
+        limits.header_timeout = std::chrono::milliseconds{header_timeout};
+    }
+    if (vm.contains("body-timeout")) {
+        limits.body_timeout = std::chrono::milliseconds{body_timeout};
+    }
+
+    if (log_mode == "async"sv) {
+        args.log_mode = util::LogMode::ASYNC;
+    } else if (log_mode == "off"sv) {
+        args.log_mode = util::LogMode::OFF;
+    } else if (!log_mode.empty() && log_mode != "sync"sv) {
+        throw std::runtime_error{"Unknown log mode "s + log_mode};
+    }
+    if (log_overflow == "block"sv) {
+        args.log_options.overflow = util::LogOverflow::BLOCK;
+    } else if (!log_overflow.empty() && log_overflow != "drop"sv) {
+        throw std::runtime_error{"Unknown log overflow policy "s + log_overflow};
+    }
+
     if (!vm.contains("config-file")) {
         throw std::runtime_error{"Config file has not been specified"s};
     }
@@ -104,45 +190,106 @@ int main(int argc, const char *argv[]) {
         if (!args) {
             return EXIT_SUCCESS;
         }
+        SetLogMode(args->log_mode, std::clog, args->log_options);
 
         // 1. Инициализируем io_context
         const unsigned num_threads = std::thread::hardware_concurrency();
         net::io_context ioc(num_threads);
-        auto api_strand = net::make_strand(ioc);
+        // В режиме thread-per-core соединения принимаются и обслуживаются в своих io_context, по потоку на каждый.
+        // Игровая модель и статические файлы остаются в общем ioc
+        std::vector<std::unique_ptr<net::io_context>> accept_contexts;
+        for (unsigned i = 0; i < args->accept_threads; ++i) {
+            accept_contexts.push_back(std::make_unique<net::io_context>(1));
+        }
 
         // 2. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc](const boost::system::error_code &ec, int signal_number) {
+        signals.async_wait([&ioc, &accept_contexts](const boost::system::error_code &ec, int signal_number) {
             if (!ec) {
                 ioc.stop();
+                for (auto &context : accept_contexts) {
+                    context->stop();
+                }
             }
         });
 
         // 3. Загружаем карту из файла и строим модель игры
         model::Game game = json_loader::LoadGame(args->config_file);
         game.SetRandomizeSpawnPoint(args->randomize_spawn_points);
+        // У каждой игровой сессии свой strand, глобальный strand только создаёт сессии и выдаёт токены
+        api_handler::Strands strands{ioc, game.GetMaps()};
+        // Игроки, подписанные через WebSocket, получают состояние своей сессии после каждого тика
+        api_handler::StateFeed state_feed{game.GetMaps()};
+        std::unordered_map<model::Map::Id, util::PendingTicks> pending_ticks;
+        // Тики сессий сверх --tick-threads ждут, пока освободится место
+        util::TickLimiter tick_limiter{args->tick_threads ? std::min(args->tick_threads, num_threads) : num_threads};
         if (args->tick_period) {
             game.SetTickPeriod(*args->tick_period);
-            Ticker ticker{api_strand, std::chrono::milliseconds{*args->tick_period},
-                          [tick_period = *args->tick_period, &game](std::chrono::milliseconds delta) {
-                              game.Tick(delta.count());
-                          }};
-            ticker.Start();
+            const std::chrono::milliseconds period{*args->tick_period};
+            // Тики сессии, чей strand не успевает, суммируются, а не копятся в очереди
+            for (const auto &map : game.GetMaps()) {
+                pending_ticks.try_emplace(map.GetId(), period, args->ticker_options);
+            }
+            // Список сессий читается на глобальном strand, затем каждая сессия тикает на своём strand
+            auto ticker = std::make_shared<Ticker>(
+                strands.Global(), period,
+                [&game, &strands, &state_feed, &pending_ticks, &tick_limiter](std::chrono::milliseconds delta) {
+                    for (auto &session : game.GetSessions()) {
+                        auto &pending = pending_ticks.at(session.GetMap().GetId());
+                        if (!pending.Add(delta)) {
+                            continue;
+                        }
+                        tick_limiter.Run([&strands, &session, &state_feed, &pending, &tick_limiter] {
+                            net::post(strands.Session(session.GetMap().GetId()),
+                                      [&session, &state_feed, &pending, &tick_limiter] {
+                                          const auto ticks = pending.Take();
+                                          for (unsigned i = 0; i < ticks.count; ++i) {
+                                              session.Tick(ticks.delta.count());
+                                          }
+                                          if (ticks.count) {
+                                              state_feed.Publish(session, ticks.count);
+                                          }
+                                          tick_limiter.Done();
+                                      });
+                        });
+                    }
+                },
+                args->ticker_options);
+            ticker->Start();
         }
 
         // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-        request_handler::RequestHandler handler{game, args->www_root, api_strand};
+        // Каталог статических файлов строится один раз и перестраивается при изменениях в www-root
+        static_content::StaticFiles static_files{ioc, args->www_root};
+        static_files.Watch();
+        request_handler::RequestHandler handler{game, static_files, strands, state_feed};
 
         // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto &&addr, auto &&req, auto &&send) {
-            handler(std::forward<decltype(addr)>(addr), std::forward<decltype(req)>(req),
-                    std::forward<decltype(send)>(send));
-        });
+        // Для WebSocket-соединений обработчик получает ещё один аргумент — функцию, которая принимает апгрейд
+        auto serve = [&handler](auto &&...args) { handler(std::forward<decltype(args)>(args)...); };
+        if (accept_contexts.empty()) {
+            http_server::ServeHttp(ioc, {address, port}, serve, args->connection_limits);
+        } else {
+            std::vector<net::io_context *> contexts;
+            for (auto &context : accept_contexts) {
+                contexts.push_back(context.get());
+            }
+            http_server::ServeHttp(contexts, {address, port}, serve, args->connection_limits);
+        }
 
         // 6. Запускаем обработку асинхронных операций
         LogStart(address.to_string(), port);
+        std::vector<std::jthread> accept_threads;
+        for (unsigned i = 0; i < accept_contexts.size(); ++i) {
+            accept_threads.emplace_back([&context = *accept_contexts[i], i] {
+                PinToCore(i);
+                // Acceptor, приостановленный ограничением числа соединений, не держит io_context занятым
+                auto work = net::make_work_guard(context);
+                context.run();
+            });
+        }
         RunWorkers(std::max(1u, num_threads), [&ioc] { ioc.run(); });
 
         // Логирование успешного завершения программы
@@ -40,6 +40,21 @@ void tag_invoke(value_from_tag, value &value, const GetPlayersResponse &response
     }
 }
 
+void WriteJson(util::JsonWriter &writer, const GetPlayersResponse &response) {
+    writer.BeginObject();
+    for (const auto &[id, player] : response.players) {
+        writer.Key(*id).BeginObject().Key("name").String(player->GetName()).EndObject();
+    }
+    writer.EndObject();
+}
+
+void WriteMsgPack(util::MsgPackWriter &writer, const GetPlayersResponse &response) {
+    writer.Map(static_cast<std::uint32_t>(response.players.size()));
+    for (const auto &[id, player] : response.players) {
+        writer.Uint(*id).Map(1).String("name").String(player->GetName());
+    }
+}
+
 void tag_invoke(value_from_tag, value &value, const GetStateResponse &response) {
     value = {};
     auto &obj = value.as_object();
@@ -47,11 +62,83 @@ void tag_invoke(value_from_tag, value &value, const GetStateResponse &response)
 
     for (const auto &[key, value] : response.players) {
         const auto &dog = value->GetDog();
-        boost::json::value ident = *value->GetId();
+        std::string ident = std::to_string(*value->GetId());
         auto [x, y] = dog->GetPosition();
         auto [dx, dy] = dog->GetSpeed();
-        obj[ident.as_string()] = {{"pos", {x, y}}, {"speed", {dx, dy}}, {"dir", serialize(dog->GetDirection())}};
+        obj["players"].as_object()[ident] = {{"pos", {x, y}}, {"speed", {dx, dy}}, {"dir", serialize(dog->GetDirection())}};
+    }
+}
+
+namespace {
+
+void WritePlayerState(util::JsonWriter &writer, const Player &player) {
+    const auto &dog = player.GetDog();
+    auto [x, y] = dog->GetPosition();
+    auto [dx, dy] = dog->GetSpeed();
+    writer.Key(*player.GetId()).BeginObject();
+    writer.Key("pos").BeginArray().Number(x).Number(y).EndArray();
+    writer.Key("speed").BeginArray().Number(dx).Number(dy).EndArray();
+    writer.Key("dir").String(serialize(dog->GetDirection()));
+    writer.EndObject();
+}
+
+void WritePlayerState(util::MsgPackWriter &writer, const Player &player) {
+    const auto &dog = player.GetDog();
+    auto [x, y] = dog->GetPosition();
+    auto [dx, dy] = dog->GetSpeed();
+    writer.Uint(*player.GetId()).Map(3);
+    writer.String("pos").Array(2).Number(x).Number(y);
+    writer.String("speed").Array(2).Number(dx).Number(dy);
+    writer.String("dir").String(serialize(dog->GetDirection()));
+}
+
+} // namespace
+
+void WriteJson(util::JsonWriter &writer, const GetStateResponse &response) {
+    writer.BeginObject().Key("players").BeginObject();
+    for (const auto &[id, player] : response.players) {
+        WritePlayerState(writer, *player);
+    }
+    writer.EndObject().EndObject();
+}
+
+void WriteJson(util::JsonWriter &writer, const GetStateDeltaResponse &response) {
+    const bool full = response.since > response.tick;
+    writer.BeginObject();
+    writer.Key("tick").Number(response.tick);
+    writer.Key("full").Bool(full);
+    writer.Key("players").BeginObject();
+    for (const auto &[id, player] : response.players) {
+        if (full || player->GetDog()->GetChangeTick() > response.since) {
+            WritePlayerState(writer, *player);
+        }
+    }
+    writer.EndObject().EndObject();
+}
+
+void WriteMsgPack(util::MsgPackWriter &writer, const GetStateResponse &response) {
+    writer.Map(1).String("players").Map(static_cast<std::uint32_t>(response.players.size()));
+    for (const auto &[id, player] : response.players) {
+        WritePlayerState(writer, *player);
+    }
+}
+
+void WriteMsgPack(util::MsgPackWriter &writer, const GetStateDeltaResponse &response) {
+    const bool full = response.since > response.tick;
+    writer.Map(3);
+    writer.String("tick").Uint(response.tick);
+    writer.String("full").Bool(full);
+    writer.String("players");
+    // The changed dogs are only known once they are written
+    const auto players = writer.BeginMap();
+    std::uint32_t written = 0;
+    for (const auto &[id, player] : response.players) {
+        if (full || player->GetDog()->GetChangeTick() > response.since) {
+            WritePlayerState(writer, *player);
+            ++written;
+        }
     }
+    writer.EndMap(players, written);
 }
 
 } // namespace api::responses
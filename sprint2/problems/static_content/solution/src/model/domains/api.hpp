@@ -8,6 +8,8 @@
 #include "game.hpp"
 #include "map.hpp"
 #include "util/error.hpp"
+#include "util/json_writer.hpp"
+#include "util/msgpack_writer.hpp"
 #include "util/response.hpp"
 
 namespace model {
@@ -56,6 +58,10 @@ struct GetPlayersResponse {
 
 // Serialize get players response to json value
 void tag_invoke(value_from_tag, value &value, const GetPlayersResponse &response);
+// Write get players response as JSON text, the same JSON document as the value above
+void WriteJson(util::JsonWriter &writer, const GetPlayersResponse &response);
+// Write get players response as MessagePack, a map of the same shape with player ids as integer keys
+void WriteMsgPack(util::MsgPackWriter &writer, const GetPlayersResponse &response);
 
 struct GetStateResponse {
     const std::unordered_map<Player::Id, std::shared_ptr<Player>> &players;
@@ -63,6 +69,24 @@ struct GetStateResponse {
 
 // Serialize get state response to json value
 void tag_invoke(value_from_tag, value &value, const GetStateResponse &response);
+// Write get state response as JSON text, the same JSON document as the value above
+void WriteJson(util::JsonWriter &writer, const GetStateResponse &response);
+// Write get state response as MessagePack, coordinates and speeds in their shortest exact encoding
+void WriteMsgPack(util::MsgPackWriter &writer, const GetStateResponse &response);
+
+// State of the players whose dogs changed after tick `since`, for clients that poll with ?since=N. A tick the
+// session has not reached yet, such as one of an earlier server run, gets the state of every player with
+// "full": true, and the client replaces its state instead of updating it.
+struct GetStateDeltaResponse {
+    const std::unordered_map<Player::Id, std::shared_ptr<Player>> &players;
+    std::uint64_t since;
+    std::uint64_t tick;
+};
+
+// Write get state delta response as JSON text: {"tick": T, "full": false, "players": {...}}
+void WriteJson(util::JsonWriter &writer, const GetStateDeltaResponse &response);
+// Write get state delta response as MessagePack, the same map as the JSON text
+void WriteMsgPack(util::MsgPackWriter &writer, const GetStateDeltaResponse &response);
 
 } // namespace api::responses
 
@@ -107,6 +131,13 @@ static util::Response parse_error() {
         .no_cache();
 }
 
+static util::Response invalid_query() {
+    return util::Response::Json(
+               status::bad_request,
+               value_from(util::Error{.code = "invalidArgument", .message = "Invalid query parameter"}))
+        .no_cache();
+}
+
 static util::Response invalid_username() {
     return util::Response::Json(status::bad_request,
                                 value_from(util::Error{.code = "invalidArgument", .message = "Invalid username"}))
@@ -0,0 +1,255 @@
+#include "dog_store.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "map.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MODEL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace model {
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+// Never equal to a rounded coordinate, marks dogs whose bounds have not been resolved yet
+constexpr double NO_POINT = std::numeric_limits<double>::quiet_NaN();
+
+struct Lanes {
+    double *x, *y, *vx, *vy;
+    const double *min_x, *max_x, *min_y, *max_y;
+    const double *point_x, *point_y;
+    std::uint8_t *queued;
+    DogStore::Index *queue;
+    std::size_t queue_size;
+};
+
+// Map point a position belongs to; ties are rounded up so that the vector kernels agree with it
+double RoundCoord(double coordinate) noexcept { return std::floor(coordinate + 0.5); }
+
+void Enqueue(Lanes &lanes, std::size_t i) noexcept {
+    if (!lanes.queued[i]) {
+        lanes.queued[i] = 1;
+        lanes.queue[lanes.queue_size++] = i;
+    }
+}
+
+// Move every dog by its speed, clamp to the road bounds and stop the dogs that have been clamped.
+// Dogs that moved to another map point are queued for a road lookup on the next tick.
+void IntegrateScalar(Lanes &lanes, std::size_t begin, std::size_t end, double seconds) noexcept {
+    for (std::size_t i = begin; i < end; ++i) {
+        const double x = lanes.x[i] + lanes.vx[i] * seconds;
+        const double y = lanes.y[i] + lanes.vy[i] * seconds;
+        const double clamped_x = std::min(std::max(x, lanes.min_x[i]), lanes.max_x[i]);
+        const double clamped_y = std::min(std::max(y, lanes.min_y[i]), lanes.max_y[i]);
+        if (clamped_x != x || clamped_y != y) {
+            lanes.vx[i] = lanes.vy[i] = 0;
+        }
+        lanes.x[i] = clamped_x;
+        lanes.y[i] = clamped_y;
+        if (RoundCoord(clamped_x) != lanes.point_x[i] || RoundCoord(clamped_y) != lanes.point_y[i]) {
+            Enqueue(lanes, i);
+        }
+    }
+}
+
+#ifdef MODEL_X86_KERNELS
+
+__attribute__((target("sse4.1"))) void IntegrateSse41(Lanes &lanes, std::size_t count, double seconds) noexcept {
+    const __m128d dt = _mm_set1_pd(seconds);
+    const __m128d half = _mm_set1_pd(0.5);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d vx = _mm_loadu_pd(lanes.vx + i), vy = _mm_loadu_pd(lanes.vy + i);
+        const __m128d x = _mm_add_pd(_mm_loadu_pd(lanes.x + i), _mm_mul_pd(vx, dt));
+        const __m128d y = _mm_add_pd(_mm_loadu_pd(lanes.y + i), _mm_mul_pd(vy, dt));
+        const __m128d clamped_x =
+            _mm_min_pd(_mm_max_pd(x, _mm_loadu_pd(lanes.min_x + i)), _mm_loadu_pd(lanes.max_x + i));
+        const __m128d clamped_y =
+            _mm_min_pd(_mm_max_pd(y, _mm_loadu_pd(lanes.min_y + i)), _mm_loadu_pd(lanes.max_y + i));
+        const __m128d stopped = _mm_or_pd(_mm_cmpneq_pd(clamped_x, x), _mm_cmpneq_pd(clamped_y, y));
+        _mm_storeu_pd(lanes.x + i, clamped_x);
+        _mm_storeu_pd(lanes.y + i, clamped_y);
+        _mm_storeu_pd(lanes.vx + i, _mm_andnot_pd(stopped, vx));
+        _mm_storeu_pd(lanes.vy + i, _mm_andnot_pd(stopped, vy));
+
+        const __m128d moved =
+            _mm_or_pd(_mm_cmpneq_pd(_mm_floor_pd(_mm_add_pd(clamped_x, half)), _mm_loadu_pd(lanes.point_x + i)),
+                      _mm_cmpneq_pd(_mm_floor_pd(_mm_add_pd(clamped_y, half)), _mm_loadu_pd(lanes.point_y + i)));
+        for (int mask = _mm_movemask_pd(moved); mask; mask &= mask - 1) {
+            Enqueue(lanes, i + __builtin_ctz(mask));
+        }
+    }
+    IntegrateScalar(lanes, i, count, seconds);
+}
+
+__attribute__((target("avx2"))) void IntegrateAvx2(Lanes &lanes, std::size_t count, double seconds) noexcept {
+    const __m256d dt = _mm256_set1_pd(seconds);
+    const __m256d half = _mm256_set1_pd(0.5);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d vx = _mm256_loadu_pd(lanes.vx + i), vy = _mm256_loadu_pd(lanes.vy + i);
+        const __m256d x = _mm256_add_pd(_mm256_loadu_pd(lanes.x + i), _mm256_mul_pd(vx, dt));
+        const __m256d y = _mm256_add_pd(_mm256_loadu_pd(lanes.y + i), _mm256_mul_pd(vy, dt));
+        const __m256d clamped_x =
+            _mm256_min_pd(_mm256_max_pd(x, _mm256_loadu_pd(lanes.min_x + i)), _mm256_loadu_pd(lanes.max_x + i));
+        const __m256d clamped_y =
+            _mm256_min_pd(_mm256_max_pd(y, _mm256_loadu_pd(lanes.min_y + i)), _mm256_loadu_pd(lanes.max_y + i));
+        const __m256d stopped = _mm256_or_pd(_mm256_cmp_pd(clamped_x, x, _CMP_NEQ_UQ),
+                                             _mm256_cmp_pd(clamped_y, y, _CMP_NEQ_UQ));
+        _mm256_storeu_pd(lanes.x + i, clamped_x);
+        _mm256_storeu_pd(lanes.y + i, clamped_y);
+        _mm256_storeu_pd(lanes.vx + i, _mm256_andnot_pd(stopped, vx));
+        _mm256_storeu_pd(lanes.vy + i, _mm256_andnot_pd(stopped, vy));
+
+        const __m256d moved = _mm256_or_pd(
+            _mm256_cmp_pd(_mm256_floor_pd(_mm256_add_pd(clamped_x, half)), _mm256_loadu_pd(lanes.point_x + i),
+                          _CMP_NEQ_UQ),
+            _mm256_cmp_pd(_mm256_floor_pd(_mm256_add_pd(clamped_y, half)), _mm256_loadu_pd(lanes.point_y + i),
+                          _CMP_NEQ_UQ));
+        for (int mask = _mm256_movemask_pd(moved); mask; mask &= mask - 1) {
+            Enqueue(lanes, i + __builtin_ctz(mask));
+        }
+    }
+    IntegrateScalar(lanes, i, count, seconds);
+}
+
+#endif
+
+void IntegrateFallback(Lanes &lanes, std::size_t count, double seconds) noexcept {
+    IntegrateScalar(lanes, 0, count, seconds);
+}
+
+using Kernel = void (*)(Lanes &, std::size_t, double) noexcept;
+
+struct KernelInfo {
+    Kernel kernel;
+    std::string_view name;
+};
+
+// The kernel is picked once, on first use, from the features of the CPU we are running on
+const KernelInfo &SelectKernel() noexcept {
+    static const KernelInfo info = []() -> KernelInfo {
+#ifdef MODEL_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return {IntegrateAvx2, "avx2"};
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return {IntegrateSse41, "sse4.1"};
+        }
+#endif
+        return {IntegrateFallback, "scalar"};
+    }();
+    return info;
+}
+
+} // namespace
+
+DogStore::Index DogStore::Add(std::pair<double, double> position) {
+    const Index index = Size();
+    x_.push_back(position.first);
+    y_.push_back(position.second);
+    vx_.push_back(0);
+    vy_.push_back(0);
+    min_x_.push_back(-INF);
+    max_x_.push_back(INF);
+    min_y_.push_back(-INF);
+    max_y_.push_back(INF);
+    point_x_.push_back(NO_POINT);
+    point_y_.push_back(NO_POINT);
+    queued_.push_back(0);
+    changed_.push_back(tick_ + 1);
+    // Every dog fits into the queue at once, so queueing never allocates during a tick
+    queue_.resize(Size());
+    Invalidate(index);
+    return index;
+}
+
+void DogStore::SetPosition(Index index, std::pair<double, double> position) noexcept {
+    x_[index] = position.first;
+    y_[index] = position.second;
+    Touch(index);
+    Invalidate(index);
+}
+
+void DogStore::SetSpeed(Index index, std::pair<double, double> speed) noexcept {
+    vx_[index] = speed.first;
+    vy_[index] = speed.second;
+    Touch(index);
+    Invalidate(index);
+}
+
+void DogStore::Tick(const Map &map, double seconds) noexcept {
+    // Only moving dogs change: they move, or stop at a road edge or off the roads
+    const auto tick = ++tick_;
+    for (std::size_t i = 0; i < Size(); ++i) {
+        if (vx_[i] != 0 || vy_[i] != 0) {
+            changed_[i] = tick;
+        }
+    }
+    UpdateBounds(map);
+
+    Lanes lanes{x_.data(),      y_.data(),      vx_.data(),     vy_.data(),  min_x_.data(), max_x_.data(),
+                min_y_.data(),  max_y_.data(),  point_x_.data(), point_y_.data(), queued_.data(), queue_.data(),
+                queue_size_};
+    SelectKernel().kernel(lanes, Size(), seconds);
+    queue_size_ = lanes.queue_size;
+}
+
+std::string_view DogStore::KernelName() noexcept { return SelectKernel().name; }
+
+// Drop the bounds of the dog and queue it for a road lookup before it moves again
+void DogStore::Invalidate(Index index) noexcept {
+    min_x_[index] = min_y_[index] = -INF;
+    max_x_[index] = max_y_[index] = INF;
+    point_x_[index] = point_y_[index] = NO_POINT;
+    if (!queued_[index]) {
+        queued_[index] = 1;
+        queue_[queue_size_++] = index;
+    }
+}
+
+void DogStore::UpdateBounds(const Map &map) noexcept {
+    for (std::size_t q = 0; q < queue_size_; ++q) {
+        const Index i = queue_[q];
+        queued_[i] = 0;
+
+        point_x_[i] = RoundCoord(x_[i]);
+        point_y_[i] = RoundCoord(y_[i]);
+        min_x_[i] = min_y_[i] = -INF;
+        max_x_[i] = max_y_[i] = INF;
+        if (vx_[i] == 0 && vy_[i] == 0) {
+            continue;
+        }
+
+        // A dog crossing a road sideways is bounded by the width of the perpendicular road
+        const Point point{static_cast<Coord>(point_x_[i]), static_cast<Coord>(point_y_[i])};
+        const bool horizontal = vx_[i] != 0;
+        auto segment = map.FindSegment(horizontal ? Orientation::HORIZONTAL : Orientation::VERTICAL, point);
+        if (!segment) {
+            segment = map.FindSegment(horizontal ? Orientation::VERTICAL : Orientation::HORIZONTAL, point);
+        }
+        if (!segment) {
+            vx_[i] = vy_[i] = 0;
+            continue;
+        }
+
+        // Only the axis of movement is bounded, the dog keeps its offset across the road. The bounds cover the
+        // whole segment, so the dog passes the joints of its roads without a lookup.
+        if (horizontal) {
+            min_x_[i] = segment->min_x;
+            max_x_[i] = segment->max_x;
+        } else {
+            min_y_[i] = segment->min_y;
+            max_y_[i] = segment->max_y;
+        }
+    }
+    queue_size_ = 0;
+}
+
+} // namespace model
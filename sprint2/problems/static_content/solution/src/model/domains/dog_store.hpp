@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "basic.hpp"
+
+namespace model {
+
+class Map;
+
+// Positions, speeds and current road bounds of every dog in a session, one contiguous array per field,
+// so the tick integrates them with a linear (and vectorized) pass instead of chasing Dog pointers.
+class DogStore {
+  public:
+    using Index = std::size_t;
+
+    Index Add(std::pair<double, double> position);
+
+    std::size_t Size() const noexcept { return x_.size(); }
+
+    std::pair<double, double> GetPosition(Index index) const noexcept { return {x_[index], y_[index]}; }
+
+    std::pair<double, double> GetSpeed(Index index) const noexcept { return {vx_[index], vy_[index]}; }
+
+    void SetPosition(Index index, std::pair<double, double> position) noexcept;
+
+    void SetSpeed(Index index, std::pair<double, double> speed) noexcept;
+
+    // Number of ticks made so far. Changes made between ticks belong to the next tick.
+    std::uint64_t GetTick() const noexcept { return tick_; }
+
+    // Tick of the last change of the dog's position, speed or direction
+    std::uint64_t GetChangeTick(Index index) const noexcept { return changed_[index]; }
+
+    // Record a change the store does not see itself, such as a new direction
+    void Touch(Index index) noexcept { changed_[index] = tick_ + 1; }
+
+    // Resolve road bounds of dogs that reached another map point, then move every dog and stop the ones
+    // that hit a road edge. Every dog that was moving counts as changed in this tick.
+    void Tick(const Map &map, double seconds) noexcept;
+
+    // Name of the integration kernel picked for this CPU: "avx2", "sse4.1" or "scalar"
+    static std::string_view KernelName() noexcept;
+
+  private:
+    void Invalidate(Index index) noexcept;
+    void UpdateBounds(const Map &map) noexcept;
+
+    std::vector<double> x_, y_;
+    std::vector<double> vx_, vy_;
+    std::vector<double> min_x_, max_x_, min_y_, max_y_;
+    // Map point the bounds were resolved for, the kernel queues dogs whose rounded position leaves it
+    std::vector<double> point_x_, point_y_;
+    std::vector<std::uint8_t> queued_;
+    std::vector<Index> queue_;
+    std::size_t queue_size_ = 0;
+    std::vector<std::uint64_t> changed_;
+    std::uint64_t tick_ = 0;
+};
+
+} // namespace model
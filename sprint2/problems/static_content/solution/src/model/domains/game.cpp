@@ -1,5 +1,8 @@
 #include "game.hpp"
 
+#include <chrono>
+#include <iomanip>
+
 using namespace std::literals;
 
 namespace model {
@@ -33,6 +36,79 @@ void tag_invoke(value_from_tag, value &value, const Game::Maps &maps) {
     value = maps_array;
 }
 
+namespace {
+
+// A tick of a session moves every dog once, usually well below a millisecond
+const util::Histogram::Bounds &TickBounds() {
+    static const util::Histogram::Bounds bounds{0.00001, 0.00005, 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1};
+    return bounds;
+}
+
+} // namespace
+
+GameSession::GameSession(const Map &map)
+    : map_(map), dogs_gauge_(util::Metrics().GetGauge("game_dogs", "Dogs on the map", {{"map", *map.GetId()}})),
+      tick_duration_(util::Metrics().GetHistogram("game_tick_duration_seconds", "Time to advance a session by one tick",
+                                                  {{"map", *map.GetId()}}, TickBounds())) {}
+
+void GameSession::Tick(double milliseconds) {
+    const auto start = std::chrono::steady_clock::now();
+    store_.Tick(map_, milliseconds / 1000.0);
+    tick_duration_.Observe(std::chrono::steady_clock::now() - start);
+}
+
+Player::Player(Id id, std::string name, GameSession &session, bool randomize_spawn_points) : session_(session) {
+    dog_ = Dog::Create(id, std::move(name), session.GetMap(), session.GetDogStore(), randomize_spawn_points);
+}
+
+PlayerTokens::PlayerTokens() {
+    tables_.push_back(std::make_unique<Table>(64));
+    table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+std::optional<PlayerRef> PlayerTokens::FindPlayerByToken(std::string_view token) const noexcept {
+    const Table &table = *table_.load(std::memory_order_acquire);
+    for (auto i = std::hash<std::string_view>{}(token) & table.mask;; i = (i + 1) & table.mask) {
+        auto entry = table.slots[i].load(std::memory_order_acquire);
+        if (!entry) {
+            return std::nullopt;
+        }
+        if (entry->token == token) {
+            return entry->player;
+        }
+    }
+}
+
+Token PlayerTokens::AddPlayer(PlayerRef player) {
+    std::stringstream stream;
+    // 32 hex digits, both halves zero-padded
+    stream << std::hex << std::setfill('0') << std::setw(16) << generator1_() << std::setw(16) << generator2_();
+    const auto &entry = entries_.emplace_back(Entry{stream.str(), player});
+
+    // Keep the table at most half full, the bigger one is filled before readers can see it
+    auto table = tables_.back().get();
+    if (entries_.size() * 2 > table->mask + 1) {
+        tables_.push_back(std::make_unique<Table>((table->mask + 1) * 2));
+        table = tables_.back().get();
+        for (const auto &old_entry : entries_) {
+            Insert(*table, old_entry);
+        }
+        table_.store(table, std::memory_order_release);
+    } else {
+        Insert(*table, entry);
+    }
+
+    return Token{entry.token};
+}
+
+void PlayerTokens::Insert(Table &table, const Entry &entry) noexcept {
+    auto i = std::hash<std::string_view>{}(entry.token) & table.mask;
+    while (table.slots[i].load(std::memory_order_relaxed)) {
+        i = (i + 1) & table.mask;
+    }
+    table.slots[i].store(&entry, std::memory_order_release);
+}
+
 void Game::AddMap(Map &&map) {
     const size_t index = maps_.size();
     if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
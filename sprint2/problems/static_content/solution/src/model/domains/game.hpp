@@ -1,16 +1,20 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <boost/json.hpp>
 
+#include <deque>
 #include <memory>
+#include <optional>
 #include <random>
 #include <sstream>
 #include <string>
 
 #include "basic.hpp"
+#include "dog_store.hpp"
 #include "map.hpp"
-#include "util/string_hash.hpp"
+#include "util/metrics.hpp"
 
 namespace model {
 
@@ -21,9 +25,15 @@ class Dog {
   public:
     using Id = util::Tagged<std::size_t, Dog>;
 
-    static std::shared_ptr<Dog> Create(std::string name, const Map &map, bool randomize_spawn_points) {
+    // Ids are unique across all sessions, sessions may hand them out concurrently
+    static Id ReserveId() {
+        static std::atomic<std::size_t> last_id = 0;
+        return Id{last_id++};
+    }
+
+    static std::shared_ptr<Dog> Create(Id id, std::string name, const Map &map, DogStore &store,
+                                       bool randomize_spawn_points) {
         // Координаты пса — случайно выбранная точка на случайно выбранном отрезке дороги этой карты
-        static std::size_t last_id = 0;
 
         std::pair<double, double> position;
         if (randomize_spawn_points) {
@@ -51,38 +61,41 @@ class Dog {
             position = {x, y};
         }
 
-        return std::shared_ptr<Dog>(new Dog(Id{last_id++}, name, position));
+        return std::shared_ptr<Dog>(new Dog(id, name, store, store.Add(position)));
     }
 
     Id GetId() const { return id_; }
 
     std::string_view GetName() const { return name_; }
 
-    std::pair<double, double> GetPosition() const { return position_; }
+    std::pair<double, double> GetPosition() const { return store_->GetPosition(index_); }
 
-    std::pair<double, double> GetSpeed() const { return speed_; }
+    std::pair<double, double> GetSpeed() const { return store_->GetSpeed(index_); }
 
     Direction GetDirection() const { return direction_; }
 
-    void SetPosition(std::pair<double, double> position) { position_ = position; }
+    void SetPosition(std::pair<double, double> position) { store_->SetPosition(index_, position); }
+
+    void SetSpeed(std::pair<double, double> speed) { store_->SetSpeed(index_, speed); }
 
-    void SetSpeed(std::pair<double, double> speed) { speed_ = speed; }
+    void SetDirection(Direction direction) {
+        direction_ = direction;
+        store_->Touch(index_);
+    }
 
-    void SetDirection(Direction direction) { direction_ = direction; }
+    // Tick of the last change of the dog, see DogStore::GetChangeTick
+    std::uint64_t GetChangeTick() const { return store_->GetChangeTick(index_); }
 
   private:
     // После добавления на карту пёс должен иметь скорость, равную нулю. Направление пса по умолчанию — на север.
-    Dog(Id id, std::string name, std::pair<double, double> position)
-        : id_(id), name_(std::move(name)), position_(position), speed_({0.0, 0.0}), direction_(Direction::NORTH) {}
+    // Координаты и скорость пса хранятся в DogStore его игровой сессии.
+    Dog(Id id, std::string name, DogStore &store, DogStore::Index index)
+        : id_(id), name_(std::move(name)), store_(&store), index_(index), direction_(Direction::NORTH) {}
 
     Id id_;
     std::string name_;
-    // Координаты пса на карте задаются двумя вещественными числами. Для описания вещественных координат разработайте
-    // структуру или класс.
-    std::pair<double, double> position_;
-    // Скорость пса на карте задаётся также двумя вещественными числами. Скорость измеряется в единицах карты за одну
-    // секунду
-    std::pair<double, double> speed_;
+    DogStore *store_;
+    DogStore::Index index_;
     // Направление в пространстве принимает одно из четырех значений: NORTH (север), SOUTH (юг), WEST (запад), EAST
     // (восток).
     Direction direction_;
@@ -93,28 +106,6 @@ Dog tag_invoke(value_to_tag<Dog>, const value &value);
 // Serialize dog to json value
 void tag_invoke(value_from_tag, value &value, const Dog &dog);
 
-class GameSession {
-  public:
-    using Dogs = std::unordered_map<Dog::Id, std::shared_ptr<Dog>>;
-
-    GameSession(const Map &map) : map_(map) {}
-
-    void AddDog(std::shared_ptr<Dog> dog) { dogs_.insert({dog->GetId(), std::move(dog)}); }
-
-    const Dogs &GetDogs() const { return dogs_; }
-
-    const Map &GetMap() const { return map_; }
-
-  private:
-    Dogs dogs_;
-    const Map &map_;
-};
-
-// Deserialize json value to game session structure
-GameSession tag_invoke(value_to_tag<GameSession>, const value &value);
-// Serialize game session to json value
-void tag_invoke(value_from_tag, value &value, const GameSession &session);
-
 namespace detail {
 
 struct TokenTag {};
@@ -123,14 +114,13 @@ struct TokenTag {};
 
 using Token = util::Tagged<std::string_view, detail::TokenTag>;
 
+class GameSession;
+
 class Player {
   public:
     using Id = Dog::Id;
 
-    Player(std::string name, GameSession &session, bool randomize_spawn_points) : session_(session) {
-        dog_ = Dog::Create(name, session.GetMap(), randomize_spawn_points);
-        session.AddDog(dog_);
-    }
+    Player(Id id, std::string name, GameSession &session, bool randomize_spawn_points);
 
     Id GetId() const { return dog_->GetId(); }
 
@@ -150,66 +140,110 @@ Player tag_invoke(value_to_tag<Player>, const value &value);
 // Serialize player to json value
 void tag_invoke(value_from_tag, value &value, const Player &player);
 
-class PlayerTokens {
+// Игровая сессия на одной карте. Все методы, кроме GetMap, вызываются только на strand этой сессии.
+class GameSession {
   public:
-    std::shared_ptr<Player> FindPlayerByToken(std::string_view token) {
-        auto it = token_to_player_.find(token);
-        if (it == token_to_player_.end()) {
-            return nullptr;
-        }
-        return it->second;
-    }
+    using Dogs = std::unordered_map<Dog::Id, std::shared_ptr<Dog>>;
+    using Players = std::unordered_map<Player::Id, std::shared_ptr<Player>>;
+
+    GameSession(const Map &map);
 
-    Token AddPlayer(std::shared_ptr<Player> player) {
-        std::stringstream stream;
-        stream << std::hex << generator1_() << generator2_();
+    GameSession(const GameSession &) = delete;
+    GameSession &operator=(const GameSession &) = delete;
 
-        std::string token(stream.str());
-        auto [it, _] = token_to_player_.insert({token, player});
+    std::shared_ptr<Player> AddPlayer(Player::Id id, std::string name, bool randomize_spawn_points) {
+        auto player = std::make_shared<Player>(id, std::move(name), *this, randomize_spawn_points);
+        dogs_.insert({id, player->GetDog()});
+        players_.insert({id, player});
+        dogs_gauge_.Add(1);
+        return player;
+    }
 
-        return Token{it->first};
+    std::shared_ptr<Player> FindPlayer(Player::Id id) const {
+        auto it = players_.find(id);
+        return it == players_.end() ? nullptr : it->second;
     }
 
+    const Players &GetPlayers() const { return players_; }
+
+    const Dogs &GetDogs() const { return dogs_; }
+
+    const Map &GetMap() const { return map_; }
+
+    DogStore &GetDogStore() { return store_; }
+
+    // Move every dog along its road for the given amount of time
+    void Tick(double milliseconds);
+
+    // Number of ticks the session has made
+    std::uint64_t GetTick() const { return store_.GetTick(); }
+
   private:
-    std::random_device random_device_;
-    std::mt19937_64 generator1_{[this] {
-        std::uniform_int_distribution<std::mt19937_64::result_type> dist;
-        return dist(random_device_);
-    }()};
-    std::mt19937_64 generator2_{[this] {
-        std::uniform_int_distribution<std::mt19937_64::result_type> dist;
-        return dist(random_device_);
-    }()};
+    Dogs dogs_;
+    Players players_;
+    DogStore store_;
+    const Map &map_;
+    // Shared by the sessions of the map in the metrics registry
+    util::Gauge &dogs_gauge_;
+    util::Histogram &tick_duration_;
+};
 
-    std::unordered_map<std::string, std::shared_ptr<Player>, string_hash, std::equal_to<>> token_to_player_;
+// Deserialize json value to game session structure
+GameSession tag_invoke(value_to_tag<GameSession>, const value &value);
+// Serialize game session to json value
+void tag_invoke(value_from_tag, value &value, const GameSession &session);
+
+// Token lookups only tell which session the player belongs to, the player itself is looked up on its session strand
+struct PlayerRef {
+    GameSession *session;
+    Player::Id id;
 };
 
-class Players {
+// Tokens are only added, from one thread at a time (the global strand), and never removed, so lookups need no lock:
+// entries and slot tables are published with release stores, and a full table is replaced instead of grown in place.
+class PlayerTokens {
   public:
-    using PlayersContainer = std::unordered_map<Map::Id, std::unordered_map<Dog::Id, std::shared_ptr<Player>>>;
+    PlayerTokens();
 
-    std::shared_ptr<Player> Add(std::string name, GameSession &session, bool randomize_spawn_points) {
-        auto player = std::make_shared<Player>(name, session, randomize_spawn_points);
-        const auto &dog = player->GetDog();
+    PlayerTokens(const PlayerTokens &) = delete;
+    PlayerTokens &operator=(const PlayerTokens &) = delete;
 
-        players_[session.GetMap().GetId()][dog->GetId()] = player;
-        return player;
-    }
+    // Safe to call from any thread, concurrently with AddPlayer
+    std::optional<PlayerRef> FindPlayerByToken(std::string_view token) const noexcept;
 
-    std::shared_ptr<Player> FindByDogIdAndMapId(Dog::Id dog_id, Map::Id map_id) const {
-        return players_.at(map_id).at(dog_id);
-    }
+    Token AddPlayer(PlayerRef player);
 
-    const std::unordered_map<Dog::Id, std::shared_ptr<Player>> &GetPlayers(const Map::Id &map_id) {
-        return players_[map_id];
-    }
+  private:
+    struct Entry {
+        std::string token;
+        PlayerRef player;
+    };
 
-    PlayersContainer::iterator begin() { return players_.begin(); }
+    // Open addressing with linear probing, a null slot ends the probe sequence
+    struct Table {
+        explicit Table(std::size_t capacity)
+            : mask(capacity - 1), slots(std::make_unique<std::atomic<const Entry *>[]>(capacity)) {}
 
-    PlayersContainer::iterator end() { return players_.end(); }
+        std::size_t mask;
+        std::unique_ptr<std::atomic<const Entry *>[]> slots;
+    };
 
-  private:
-    PlayersContainer players_;
+    static void Insert(Table &table, const Entry &entry) noexcept;
+
+    std::random_device random_device_;
+    std::mt19937_64 generator1_{[this] {
+        std::uniform_int_distribution<std::mt19937_64::result_type> dist;
+        return dist(random_device_);
+    }()};
+    std::mt19937_64 generator2_{[this] {
+        std::uniform_int_distribution<std::mt19937_64::result_type> dist;
+        return dist(random_device_);
+    }()};
+
+    // Entries never move, readers may still hold pointers to them and to replaced tables
+    std::deque<Entry> entries_;
+    std::vector<std::unique_ptr<Table>> tables_;
+    std::atomic<const Table *> table_;
 };
 
 class Game {
@@ -228,7 +262,14 @@ class Game {
 
     Map &GetMap(const Map::Id &id) noexcept { return maps_[map_id_to_index_.at(id)]; }
 
-    void AddSession(GameSession &&session) { sessions_.push_back(std::move(session)); }
+    GameSession &AddSession(const Map &map) {
+        sessions_gauge_.Add(1);
+        return sessions_.emplace_back(map);
+    }
+
+    const std::deque<GameSession> &GetSessions() const { return sessions_; }
+
+    std::deque<GameSession> &GetSessions() { return sessions_; }
 
     bool ContainsSession(const Map::Id &id) noexcept {
         return std::find_if(sessions_.begin(), sessions_.end(),
@@ -240,16 +281,20 @@ class Game {
                              [&](const auto &session) { return id == session.GetMap().GetId(); });
     }
 
-    std::pair<std::shared_ptr<Player>, Token> AddPlayer(std::string username, GameSession &session) {
-        auto player = players_.Add(std::move(username), session, randomize_spawn_points_);
-        auto token = player_tokens_.AddPlayer(player);
-        return {player, token};
+    // Token half of joining a player: reserves the player id and issues its token without touching the session
+    std::pair<Player::Id, Token> AddPlayerToken(GameSession &session) {
+        auto id = Dog::ReserveId();
+        return {id, player_tokens_.AddPlayer(PlayerRef{&session, id})};
     }
 
-    std::shared_ptr<Player> GetPlayer(std::string_view token) { return player_tokens_.FindPlayerByToken(token); }
+    // Join a player in one step, for callers that own both the game and the session
+    std::pair<std::shared_ptr<Player>, Token> AddPlayer(std::string username, GameSession &session) {
+        auto [id, token] = AddPlayerToken(session);
+        return {session.AddPlayer(id, std::move(username), randomize_spawn_points_), token};
+    }
 
-    const std::unordered_map<Dog::Id, std::shared_ptr<Player>> &GetPlayers(const Map::Id &map_id) {
-        return players_.GetPlayers(map_id);
+    std::optional<PlayerRef> FindPlayerByToken(std::string_view token) const {
+        return player_tokens_.FindPlayerByToken(token);
     }
 
     std::optional<int> GetTickPeriod() const { return tick_period_; }
@@ -260,55 +305,10 @@ class Game {
 
     void SetRandomizeSpawnPoint(bool randomize_spawn_points) { randomize_spawn_points_ = randomize_spawn_points; }
 
+    // Advance every session; maps are borrowed by reference and the loop does not allocate
     void Tick(double milliseconds) {
-        for (auto &[_, players] : players_) {
-            for (auto &[_, player] : players) {
-                auto [dx, dy] = player->GetDog()->GetSpeed();
-                if (dx == 0 && dy == 0) {
-                    continue;
-                }
-
-                auto [x, y] = player->GetDog()->GetPosition();
-                auto current_point = Point{static_cast<int>(std::round(x)), static_cast<int>(std::round(y))};
-                auto [point_x, point_y] = current_point;
-
-                auto map = player->GetSession().GetMap();
-
-                auto road = map.GetPointsToRoads()
-                                .at(dx != 0 ? Orientation::HORIZONTAL : Orientation::VERTICAL)
-                                .at(current_point);
-                auto [start_x, start_y] = road->GetStart();
-                auto [end_x, end_y] = road->GetEnd();
-
-                auto need_to_stop = false;
-                auto get_new_coordinate = [&](double original_dimension, double dimension_shift, double start_dimension,
-                                              double end_dimension) {
-                    auto new_coordinate = original_dimension + dimension_shift;
-                    if (dimension_shift > 0) {
-                        if (new_coordinate > (end_dimension + 0.4)) {
-                            need_to_stop = true;
-                            return end_dimension + 0.4;
-                        }
-                    } else if (dimension_shift < 0) {
-                        if (new_coordinate < (start_dimension - 0.4)) {
-                            need_to_stop = true;
-                            return start_dimension - 0.4;
-                        }
-                    }
-                    return new_coordinate;
-                };
-
-                if (dx == 0) {
-                    y = get_new_coordinate(y, dy * (milliseconds / 1000.0), start_y, end_y);
-                } else if (dy == 0) {
-                    x = get_new_coordinate(x, dx * (milliseconds / 1000.0), start_x, end_x);
-                }
-                if (need_to_stop) {
-                    player->GetDog()->SetSpeed({0, 0});
-                }
-
-                player->GetDog()->SetPosition({x, y});
-            }
+        for (auto &session : sessions_) {
+            session.Tick(milliseconds);
         }
     }
 
@@ -319,11 +319,12 @@ class Game {
 
     std::vector<Map> maps_;
     MapIdToIndex map_id_to_index_;
-    std::vector<GameSession> sessions_;
-    Players players_;
+    // Players and dogs keep references to their session, so sessions must never be relocated
+    std::deque<GameSession> sessions_;
     PlayerTokens player_tokens_;
     std::optional<int> tick_period_;
-    bool randomize_spawn_points_;
+    bool randomize_spawn_points_{false};
+    util::Gauge &sessions_gauge_ = util::Metrics().GetGauge("game_sessions", "Game sessions running");
 };
 
 // Deserialize json value to game structure
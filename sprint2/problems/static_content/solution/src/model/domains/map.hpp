@@ -4,6 +4,8 @@
 #include <unordered_map>
 
 #include "basic.hpp"
+#include "road_index.hpp"
+#include "road_segments.hpp"
 #include "util/tagged.hpp"
 
 namespace model {
@@ -88,11 +90,6 @@ class Map {
   public:
     using Id = util::Tagged<std::string, Map>;
     using Roads = std::vector<Road>;
-    using PointsToRoads =
-        std::unordered_map<Orientation, std::unordered_map<Point, const Road *, decltype([](const Point &point) {
-                                                               return std::hash<int>()(point.x) ^
-                                                                      std::hash<int>()(point.y);
-                                                           })>>;
     using Buildings = std::vector<Building>;
     using Offices = std::vector<Office>;
 
@@ -105,20 +102,8 @@ class Map {
         for (auto &&office : offices) {
             AddOffice(std::move(office));
         }
-        for (const auto &road : roads) {
-            auto current_point = road.GetStart(), end_point = road.GetEnd();
-            if (road.IsHorizontal()) {
-                while (current_point.x <= end_point.x) {
-                    point_to_road_[Orientation::HORIZONTAL][current_point] = &road;
-                    current_point.x += 1;
-                }
-            } else if (road.IsVertical()) {
-                while (current_point.y <= end_point.y) {
-                    point_to_road_[Orientation::VERTICAL][current_point] = &road;
-                    current_point.y += 1;
-                }
-            }
-        }
+        road_index_ = RoadIndex{roads_};
+        road_segments_ = RoadSegments{roads_};
     }
 
     const Id &GetId() const noexcept { return id_; }
@@ -129,13 +114,25 @@ class Map {
 
     const Roads &GetRoads() const noexcept { return roads_; }
 
-    const PointsToRoads &GetPointsToRoads() const noexcept { return point_to_road_; }
+    // Road of the given orientation passing through the point, nullptr if there is none
+    const Road *FindRoad(Orientation orientation, Point point) const noexcept {
+        auto id = road_index_.Find(orientation, point);
+        return id == RoadIndex::NO_ROAD ? nullptr : &roads_[id];
+    }
+
+    const RoadSegments &GetRoadSegments() const noexcept { return road_segments_; }
+
+    // Segment of the roads of the given orientation passing through the point, nullptr if there is none
+    const RoadSegments::Segment *FindSegment(Orientation orientation, Point point) const noexcept {
+        auto id = road_index_.Find(orientation, point);
+        return id == RoadIndex::NO_ROAD ? nullptr : &road_segments_.OfRoad(id);
+    }
 
     const Offices &GetOffices() const noexcept { return offices_; }
 
     void SetDogSpeed(double dog_speed) { dog_speed_ = dog_speed; }
 
-    std::optional<double> GetDogSpeed() { return dog_speed_; }
+    std::optional<double> GetDogSpeed() const { return dog_speed_; }
 
   private:
     using OfficeIdToIndex = std::unordered_map<Office::Id, size_t>;
@@ -145,7 +142,8 @@ class Map {
     Id id_;
     std::string name_;
     Roads roads_;
-    PointsToRoads point_to_road_;
+    RoadIndex road_index_;
+    RoadSegments road_segments_;
     Buildings buildings_;
     std::optional<double> dog_speed_;
 
@@ -0,0 +1,106 @@
+#include "road_index.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+#include "map.hpp"
+
+namespace model {
+
+RoadIndex::RoadIndex(const std::vector<Road> &roads) {
+    if (roads.empty()) {
+        return;
+    }
+
+    Point min = roads.front().GetStart(), max = min;
+    for (const auto &road : roads) {
+        for (auto point : {road.GetStart(), road.GetEnd()}) {
+            min = {std::min(min.x, point.x), std::min(min.y, point.y)};
+            max = {std::max(max.x, point.x), std::max(max.y, point.y)};
+        }
+    }
+
+    // In 64 bits: the extent of coordinates far apart does not fit into a Coord
+    origin_ = min;
+    width_ = static_cast<std::int64_t>(max.x) - min.x + 1;
+    height_ = static_cast<std::int64_t>(max.y) - min.y + 1;
+    dense_ = static_cast<std::uint64_t>(width_) <= MAX_DENSE_CELLS / static_cast<std::uint64_t>(height_);
+    if (dense_) {
+        BuildGrid(roads);
+    } else {
+        BuildIntervals(roads);
+    }
+}
+
+void RoadIndex::BuildGrid(const std::vector<Road> &roads) {
+    const auto cell_count = static_cast<std::size_t>(width_ * height_);
+    horizontal_.assign(cell_count, NO_ROAD);
+    vertical_.assign(cell_count, NO_ROAD);
+
+    for (RoadId id = 0; id < roads.size(); ++id) {
+        const auto &road = roads[id];
+        auto [start_x, start_y] = road.GetStart();
+        auto [end_x, end_y] = road.GetEnd();
+        auto [from_x, to_x] = std::minmax(start_x, end_x);
+        auto [from_y, to_y] = std::minmax(start_y, end_y);
+
+        auto &cells = road.IsHorizontal() ? horizontal_ : vertical_;
+        for (Coord y = from_y; y <= to_y; ++y) {
+            const auto row = static_cast<std::size_t>((y - origin_.y) * width_);
+            for (Coord x = from_x; x <= to_x; ++x) {
+                cells[row + static_cast<std::size_t>(x - origin_.x)] = id;
+            }
+        }
+    }
+}
+
+void RoadIndex::BuildIntervals(const std::vector<Road> &roads) {
+    for (RoadId id = 0; id < roads.size(); ++id) {
+        const auto &road = roads[id];
+        const auto start = road.GetStart(), end = road.GetEnd();
+        if (road.IsHorizontal()) {
+            horizontal_intervals_.push_back({start.y, std::min(start.x, end.x), std::max(start.x, end.x), id});
+        } else {
+            vertical_intervals_.push_back({start.x, std::min(start.y, end.y), std::max(start.y, end.y), id});
+        }
+    }
+
+    // Overlapping roads are cut, so that the intervals of a line are disjoint and a binary search finds the one
+    // covering a point. As in the grid, a point shared by several roads belongs to one of them.
+    for (auto *intervals : {&horizontal_intervals_, &vertical_intervals_}) {
+        std::sort(intervals->begin(), intervals->end(), [](const Interval &lhs, const Interval &rhs) {
+            return std::tie(lhs.line, lhs.from) < std::tie(rhs.line, rhs.from);
+        });
+        std::vector<Interval> disjoint;
+        disjoint.reserve(intervals->size());
+        for (auto interval : *intervals) {
+            if (!disjoint.empty() && disjoint.back().line == interval.line) {
+                const auto covered = disjoint.back().to;
+                if (interval.to <= covered) {
+                    continue;
+                }
+                interval.from = std::max(interval.from, covered + 1);
+            }
+            disjoint.push_back(interval);
+        }
+        *intervals = std::move(disjoint);
+    }
+}
+
+RoadIndex::RoadId RoadIndex::FindInterval(Orientation orientation, Point point) const noexcept {
+    const auto &intervals = orientation == Orientation::HORIZONTAL ? horizontal_intervals_ : vertical_intervals_;
+    const auto [line, position] = orientation == Orientation::HORIZONTAL ? std::pair{point.y, point.x}
+                                                                         : std::pair{point.x, point.y};
+    // The last interval starting at or before the point
+    auto it = std::upper_bound(intervals.begin(), intervals.end(), std::pair{line, position},
+                               [](const auto &key, const Interval &interval) {
+                                   return key < std::pair{interval.line, interval.from};
+                               });
+    if (it == intervals.begin()) {
+        return NO_ROAD;
+    }
+    --it;
+    return it->line == line && position <= it->to ? it->road : NO_ROAD;
+}
+
+} // namespace model
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "basic.hpp"
+
+namespace model {
+
+class Road;
+
+// Dense grid over the map bounding box: every integer point stores the index of the road that covers it,
+// one flat array per orientation. Built once, lookups are a bounds check and a single array read.
+// Maps whose bounding box would take more than MAX_DENSE_CELLS points, sparse or with far-off coordinates, keep the
+// roads of each orientation as disjoint intervals sorted by line instead, looked up by binary search.
+class RoadIndex {
+  public:
+    using RoadId = std::uint32_t;
+    static constexpr RoadId NO_ROAD = std::numeric_limits<RoadId>::max();
+    // 4M points, 32 MiB for the grids of both orientations
+    static constexpr std::uint64_t MAX_DENSE_CELLS = 1 << 22;
+
+    RoadIndex() = default;
+    explicit RoadIndex(const std::vector<Road> &roads);
+
+    RoadId Find(Orientation orientation, Point point) const noexcept {
+        if (!dense_) {
+            return FindInterval(orientation, point);
+        }
+        const auto x = static_cast<std::int64_t>(point.x) - origin_.x;
+        const auto y = static_cast<std::int64_t>(point.y) - origin_.y;
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+            return NO_ROAD;
+        }
+
+        const auto &cells = orientation == Orientation::HORIZONTAL ? horizontal_ : vertical_;
+        return cells[static_cast<std::size_t>(y * width_ + x)];
+    }
+
+    bool IsDense() const noexcept { return dense_; }
+
+  private:
+    // Part of a road on its line: y of a horizontal road and x of a vertical one
+    struct Interval {
+        Coord line;
+        Coord from, to;
+        RoadId road;
+    };
+
+    void BuildGrid(const std::vector<Road> &roads);
+    void BuildIntervals(const std::vector<Road> &roads);
+    RoadId FindInterval(Orientation orientation, Point point) const noexcept;
+
+    bool dense_ = true;
+    Point origin_{0, 0};
+    std::int64_t width_ = 0, height_ = 0;
+    std::vector<RoadId> horizontal_;
+    std::vector<RoadId> vertical_;
+    std::vector<Interval> horizontal_intervals_;
+    std::vector<Interval> vertical_intervals_;
+};
+
+} // namespace model
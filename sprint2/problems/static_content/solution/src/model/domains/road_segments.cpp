@@ -0,0 +1,71 @@
+#include "road_segments.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+#include "map.hpp"
+
+namespace model {
+
+namespace {
+
+// Line of a road and the interval it covers on it
+struct Span {
+    Orientation orientation;
+    Coord line;
+    Coord from, to;
+};
+
+Span SpanOf(const Road &road) {
+    const auto start = road.GetStart(), end = road.GetEnd();
+    if (road.IsHorizontal()) {
+        return {Orientation::HORIZONTAL, start.y, std::min(start.x, end.x), std::max(start.x, end.x)};
+    }
+    return {Orientation::VERTICAL, start.x, std::min(start.y, end.y), std::max(start.y, end.y)};
+}
+
+} // namespace
+
+RoadSegments::RoadSegments(const std::vector<Road> &roads) : segment_of_(roads.size()) {
+    std::vector<Span> spans;
+    spans.reserve(roads.size());
+    for (const auto &road : roads) {
+        spans.push_back(SpanOf(road));
+    }
+
+    // Roads of a line in the order of their starts, so that a segment is a run of them
+    std::vector<RoadIndex::RoadId> order(roads.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](auto lhs, auto rhs) {
+        const auto &a = spans[lhs], &b = spans[rhs];
+        return std::tie(a.orientation, a.line, a.from) < std::tie(b.orientation, b.line, b.from);
+    });
+
+    for (std::size_t begin = 0; begin < order.size();) {
+        auto span = spans[order[begin]];
+        auto end = begin + 1;
+        for (; end < order.size(); ++end) {
+            const auto &next = spans[order[end]];
+            if (next.orientation != span.orientation || next.line != span.line || next.from > span.to) {
+                break;
+            }
+            span.to = std::max(span.to, next.to);
+        }
+
+        const auto id = static_cast<std::uint32_t>(segments_.size());
+        const double line_min = span.line - HALF_WIDTH, line_max = span.line + HALF_WIDTH;
+        const double from = span.from - HALF_WIDTH, to = span.to + HALF_WIDTH;
+        if (span.orientation == Orientation::HORIZONTAL) {
+            segments_.push_back({from, to, line_min, line_max});
+        } else {
+            segments_.push_back({line_min, line_max, from, to});
+        }
+        for (auto i = begin; i < end; ++i) {
+            segment_of_[order[i]] = id;
+        }
+        begin = end;
+    }
+}
+
+} // namespace model
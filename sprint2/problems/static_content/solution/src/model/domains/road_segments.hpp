@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "basic.hpp"
+#include "road_index.hpp"
+
+namespace model {
+
+class Road;
+
+// Collinear roads that overlap or touch, joined into segments: a dog runs along a segment without stopping where
+// one of its roads ends and the next begins, however many of them it passes in a tick. Built once with the map,
+// every road knows its segment.
+class RoadSegments {
+  public:
+    // How far a dog may step off the road axis
+    static constexpr double HALF_WIDTH = 0.4;
+
+    // Area of the segment with the road width, dogs on it keep inside
+    struct Segment {
+        double min_x, max_x;
+        double min_y, max_y;
+    };
+
+    RoadSegments() = default;
+    explicit RoadSegments(const std::vector<Road> &roads);
+
+    const Segment &OfRoad(RoadIndex::RoadId road) const noexcept { return segments_[segment_of_[road]]; }
+
+    const std::vector<Segment> &GetSegments() const noexcept { return segments_; }
+
+  private:
+    std::vector<Segment> segments_;
+    std::vector<std::uint32_t> segment_of_;
+};
+
+} // namespace model
@@ -1,27 +1,195 @@
 #include "request_handler.hpp"
 
-#include "util/filesystem.hpp"
-#include "util/mime_type.hpp"
+#include <fstream>
+#include <optional>
+
+#include "static_content/range.hpp"
+#include "util/etag.hpp"
+#include "util/http_date.hpp"
 
 namespace request_handler {
 
+namespace {
+
+using static_content::ByteRange;
+using static_content::StaticFiles;
+
+// Larger multipart bodies are not assembled, the whole file is sent instead
+constexpr std::uint64_t MAX_MULTIPART_BODY = 1024 * 1024;
+constexpr std::string_view MULTIPART_BOUNDARY = "3d6b6a416f9b5";
+
+std::string ContentRange(const ByteRange &range, std::uint64_t size) {
+    return "bytes "s + std::to_string(range.first) + '-' + std::to_string(range.last) + '/' + std::to_string(size);
+}
+
+// Cached contents are sliced, files sent from disk are read at the offset
+std::optional<std::string> ReadRange(const StaticFiles::Selected &selected, const ByteRange &range) {
+    if (selected.content) {
+        return selected.content->substr(range.first, range.Size());
+    }
+    std::ifstream in{selected.path, std::ios::binary};
+    std::string data(range.Size(), '\0');
+    if (!in.seekg(static_cast<std::streamoff>(range.first)) ||
+        !in.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+        return std::nullopt;
+    }
+    return data;
+}
+
+std::optional<std::string> MultipartByteRanges(const StaticFiles::Selected &selected, std::string_view mime_type,
+                                               const std::vector<ByteRange> &ranges) {
+    std::string body;
+    for (const auto &range : ranges) {
+        auto part = ReadRange(selected, range);
+        if (!part) {
+            return std::nullopt;
+        }
+        body.append("\r\n--"sv).append(MULTIPART_BOUNDARY);
+        body.append("\r\nContent-Type: "sv).append(mime_type);
+        body.append("\r\nContent-Range: "sv).append(ContentRange(range, selected.size));
+        body.append("\r\n\r\n"sv).append(*part);
+    }
+    body.append("\r\n--"sv).append(MULTIPART_BOUNDARY).append("--\r\n"sv);
+    return body;
+}
+
+// If-Range holds either a strong tag or the exact Last-Modified date of the representation
+bool IfRangeMatches(std::string_view if_range, const StaticFiles::File &file, std::string_view etag) {
+    if (if_range.empty()) {
+        return true;
+    }
+    if (if_range.starts_with('"') || if_range.starts_with("W/"sv)) {
+        return if_range == etag;
+    }
+    auto date = ParseHttpDate(if_range);
+    return date && *date == file.modified;
+}
+
+} // namespace
+
+RequestHandler::RequestHandler(model::Game &game, const static_content::StaticFiles &static_files,
+                               api_handler::Strands &strands, api_handler::StateFeed &state_feed)
+    : game_(game), strands_(strands), state_feed_(state_feed), api_(game, strands), static_files_(static_files),
+      static_route_(MakeRouteMetrics("static"sv)), metrics_route_(MakeRouteMetrics(METRICS_TARGET)),
+      state_feed_route_(MakeRouteMetrics(STATE_FEED_TARGET)) {
+    for (auto pattern : api_.Patterns()) {
+        route_metrics_.emplace(std::string{pattern}, MakeRouteMetrics(pattern));
+    }
+    static constexpr std::array<std::string_view, 6> classes{"other"sv, "1xx"sv, "2xx"sv,
+                                                             "3xx"sv,   "4xx"sv, "5xx"sv};
+    for (std::size_t i = 0; i < classes.size(); ++i) {
+        responses_[i] = &Metrics().GetCounter("http_responses_total"sv, "HTTP responses by status class"sv,
+                                              {{"code"s, std::string{classes[i]}}});
+    }
+}
+
+RequestHandler::RouteMetrics RequestHandler::MakeRouteMetrics(std::string_view route) {
+    const MetricLabels labels{{"route"s, std::string{route}}};
+    return {Metrics().GetCounter("http_requests_total"sv, "HTTP requests by route"sv, labels),
+            Metrics().GetHistogram("http_request_duration_seconds"sv,
+                                   "Time from reading a request to its response being ready"sv, labels)};
+}
+
+Response RequestHandler::get_metrics(http::verb method) const {
+    if (method != http::verb::get && method != http::verb::head) {
+        return Response::Text(http::status::method_not_allowed, "Invalid method").allow("GET, HEAD"sv);
+    }
+    return Response::Buffer(http::status::ok, "text/plain; version=0.0.4; charset=utf-8"sv,
+                            std::make_shared<const std::string>(Metrics().Expose()))
+        .no_cache();
+}
+
 // Handle static files requests
-Response RequestHandler::get_file(std::string_view target) const {
-    Response response;
+Response RequestHandler::get_file(const FileRequest &request) const {
+    using Status = StaticFiles::Lookup::Status;
+    using Ranges = static_content::RangeRequest::Status;
 
-    auto path = GetPath(target, base_path_);
-    if (ValidatePath(path, base_path_)) {
-        auto extension = path.extension().string();
+    auto [status, file] = static_files_.Find(request.target);
+    if (status == Status::INVALID_PATH) {
+        return Response::Text(http::status::bad_request, "Invalid path");
+    }
+    if (status == Status::NOT_FOUND) {
+        return Response::Text(http::status::not_found, "File not found");
+    }
 
+    auto selected = file->Select(request.accept_encoding);
+    auto set_validators = [&](Response &response) {
+        response.set("Last-Modified", file->last_modified);
+        if (file->HasEncodings()) {
+            response.set("Vary", "Accept-Encoding");
+        }
+    };
+
+    // If-Modified-Since only counts when there is no If-None-Match
+    bool not_modified = false;
+    if (!request.if_none_match.empty()) {
+        not_modified = ETagMatches(request.if_none_match, selected.etag);
+    } else if (!request.if_modified_since.empty()) {
+        auto since = ParseHttpDate(request.if_modified_since);
+        not_modified = since && file->modified <= *since;
+    }
+    if (not_modified) {
+        auto response = Response::NotModified(selected.etag);
+        set_validators(response);
+        return response;
+    }
+
+    static_content::RangeRequest ranges;
+    if (!request.range.empty() && IfRangeMatches(request.if_range, *file, selected.etag)) {
+        ranges = static_content::ParseRange(request.range, selected.size);
+    }
+
+    Response response;
+    if (ranges.status == Ranges::UNSATISFIABLE) {
+        response = Response::Text(http::status::range_not_satisfiable, "Range not satisfiable");
+        response.set("Content-Range", "bytes */"s + std::to_string(selected.size));
+        return response;
+    }
+
+    std::uint64_t multipart_size = 0;
+    for (const auto &range : ranges.ranges) {
+        multipart_size += range.Size();
+    }
+    if (ranges.ranges.size() > 1 && multipart_size <= MAX_MULTIPART_BODY) {
+        auto body = MultipartByteRanges(selected, file->mime_type, ranges.ranges);
+        if (!body) {
+            return Response::Text(http::status::not_found, "File not found");
+        }
+        response = Response::Buffer(http::status::partial_content,
+                                    "multipart/byteranges; boundary="s + std::string{MULTIPART_BOUNDARY},
+                                    std::make_shared<const std::string>(std::move(*body)));
+    } else if (ranges.ranges.size() == 1) {
+        const auto &range = ranges.ranges.front();
         boost::system::error_code ec;
-        response = Response::File(http::status::ok, GetMimeType(extension), path.string(), ec);
-        if (ec)
-            response = Response::Text(http::status::not_found, "File not found");
+        if (selected.content) {
+            response = Response::Buffer(http::status::partial_content, file->mime_type,
+                                        std::make_shared<const std::string>(*ReadRange(selected, range)));
+        } else {
+            response = Response::FilePart(http::status::partial_content, file->mime_type, selected.path.string(),
+                                          range.first, range.Size(), ec);
+        }
+        if (ec) {
+            return Response::Text(http::status::not_found, "File not found");
+        }
+        response.set("Content-Range", ContentRange(range, selected.size));
+    } else if (selected.content) {
+        // Small files are served from memory, the rest is sent from disk
+        response = Response::Buffer(http::status::ok, file->mime_type, selected.content);
     } else {
-        response = Response::Text(http::status::bad_request, "Invalid path");
+        boost::system::error_code ec;
+        response = Response::File(http::status::ok, file->mime_type, selected.path.string(), ec);
+        if (ec) {
+            return Response::Text(http::status::not_found, "File not found");
+        }
     }
 
+    if (!selected.encoding.empty()) {
+        response.set("Content-Encoding", selected.encoding);
+    }
+    response.set("Accept-Ranges", "bytes");
+    response.set("ETag", selected.etag);
+    set_validators(response);
     return response;
 }
 
-} // namespace request_handler
\ No newline at end of file
+} // namespace request_handler
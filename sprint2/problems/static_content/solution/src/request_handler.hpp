@@ -1,14 +1,22 @@
 #pragma once
 
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
+#include <array>
 #include <chrono>
 #include <filesystem>
+#include <unordered_map>
 
 #include "api_handler/api_handler.hpp"
+#include "api_handler/state_feed.hpp"
+#include "http_server.hpp"
 #include "model/model.hpp"
+#include "static_content/static_files.hpp"
 #include "util/logging.hpp"
+#include "util/metrics.hpp"
 #include "util/response.hpp"
+#include "util/string_hash.hpp"
 
 namespace request_handler {
 
@@ -21,48 +29,185 @@ using namespace util;
 
 using StringRequest = http::request<http::string_body>;
 
-class RequestHandler {
+// Subscriber of the state feed on the other end of a WebSocket connection
+class WebSocketSubscriber : public api_handler::StateFeed::Subscriber {
   public:
-    using Strand = beast::net::strand<beast::net::io_context::executor_type>;
+    explicit WebSocketSubscriber(std::shared_ptr<http_server::WebSocketSession> session)
+        : session_(std::move(session)) {}
+
+    bool Push(const api_handler::StateFeed::Message &message, bool full) override {
+        return session_->Send(message, full);
+    }
+    bool TakeLagged() override { return session_->TakeLagged(); }
 
-    explicit RequestHandler(model::Game &game, std::string_view static_path, Strand api_strand)
-        : api_(game), base_path_(static_path), api_strand_(api_strand) {}
+  private:
+    std::shared_ptr<http_server::WebSocketSession> session_;
+};
+
+class RequestHandler {
+  public:
+    explicit RequestHandler(model::Game &game, const static_content::StaticFiles &static_files,
+                            api_handler::Strands &strands, api_handler::StateFeed &state_feed);
 
     RequestHandler(const RequestHandler &) = delete;
     RequestHandler &operator=(const RequestHandler &) = delete;
 
+    // The body buffer belongs to the connection and is free until the response is written. The request belongs
+    // to the connection too and is only read during the call.
     template <typename Body, typename Allocator, typename Send>
-    void operator()(std::string_view address, http::request<Body, http::basic_fields<Allocator>> &&request,
-                    Send &&send) const {
+    void operator()(std::string_view address, const http::request<Body, http::basic_fields<Allocator>> &request,
+                    BodyBuffer body_buffer, Send &&send) const {
         auto target = request.target();
 
         LogRequest(address, target, request.method_string());
-        auto start_ts = std::chrono::system_clock::now();
 
-        Response response;
-        bool is_api_request = api_.dispatch(request, response);
-        if (!is_api_request) {
-            response = get_file(target);
+        auto match = api_.Find(target);
+        const bool is_metrics = !match.target && target.substr(0, target.find('?')) == METRICS_TARGET;
+        const auto &route = match.target ? route_metrics_.find(match.pattern)->second
+                                         : (is_metrics ? metrics_route_ : static_route_);
+        route.requests.Inc();
+
+        // API endpoints may respond later from the strand of a game session
+        Endpoint::Respond respond{Finish(route, std::forward<Send>(send), request), std::move(body_buffer)};
+
+        if (match.target) {
+            api_.Dispatch(match, request, std::move(respond));
+        } else if (is_metrics) {
+            respond(get_metrics(request.method()));
+        } else {
+            respond(get_file({target, request[http::field::accept_encoding], request[http::field::if_none_match],
+                              request[http::field::if_modified_since], request[http::field::range],
+                              request[http::field::if_range]}));
         }
+    }
 
-        auto end_ts = std::chrono::system_clock::now();
-        LogResponse(std::chrono::duration_cast<std::chrono::milliseconds>(end_ts - start_ts).count(), response.code(),
-                    response.content_type());
+    // WebSocket upgrade requests. Only the state feed is served over WebSocket, other upgrades are handled as
+    // ordinary requests.
+    template <typename Body, typename Allocator, typename Send, typename Accept>
+    void operator()(std::string_view address, const http::request<Body, http::basic_fields<Allocator>> &request,
+                    BodyBuffer body_buffer, Send &&send, Accept &&accept) const {
+        auto target = request.target();
+        if (target.substr(0, target.find('?')) != STATE_FEED_TARGET) {
+            return (*this)(address, request, std::move(body_buffer), std::forward<Send>(send));
+        }
 
-        response.finalize(request.version(), request.keep_alive());
-        if (is_api_request)
-            response.send(send, api_strand_);
-        else
-            response.send(send);
+        LogRequest(address, target, request.method_string());
+        state_feed_route_.requests.Inc();
+        auto finish = Finish(state_feed_route_, std::forward<Send>(send), request);
+
+        // Browsers cannot set headers on WebSocket requests, so the token may come in the query too
+        auto token = GetToken(request);
+        if (!token) {
+            return finish(model::api::errors::no_token());
+        }
+        auto ref = game_.FindPlayerByToken(*token);
+        if (!ref) {
+            return finish(model::api::errors::no_user_found());
+        }
+
+        auto &strand = strands_.Session(ref->session->GetMap().GetId());
+        net::dispatch(strand, [this, &strand, ref = *ref, finish = std::move(finish),
+                               accept = std::forward<Accept>(accept),
+                               start_ts = std::chrono::steady_clock::now()]() mutable {
+            if (!ref.session->FindPlayer(ref.id)) {
+                return finish(model::api::errors::no_user_found());
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start_ts;
+            state_feed_route_.duration.Observe(elapsed);
+            CountResponse(101);
+            LogResponse(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 101, ""sv);
+
+            accept([this, &strand, session = ref.session](std::shared_ptr<http_server::WebSocketSession> ws) {
+                net::dispatch(strand, [this, session, ws = std::move(ws)]() mutable {
+                    state_feed_.Subscribe(*session, std::make_shared<WebSocketSubscriber>(std::move(ws)));
+                });
+            });
+        });
     }
 
   private:
+    static constexpr std::string_view METRICS_TARGET = "/metrics"sv;
+    static constexpr std::string_view STATE_FEED_TARGET = "/api/v1/game/ws"sv;
+
+    // Token of the state feed, from the Authorization header or the token parameter of the query
+    template <typename Request>
+    static std::optional<std::string_view> GetToken(const Request &request) {
+        constexpr std::string_view authorization_prefix = "Bearer "sv;
+        if (auto it = request.find(http::field::authorization); it != request.end()) {
+            std::string_view value = it->value();
+            if (value.starts_with(authorization_prefix) && value.size() > authorization_prefix.size()) {
+                return value.substr(authorization_prefix.size());
+            }
+            return std::nullopt;
+        }
+        auto target = request.target();
+        for (auto query = target.substr(std::min(target.find('?'), target.size())); !query.empty();) {
+            query.remove_prefix(1);
+            auto parameter = query.substr(0, query.find('&'));
+            query.remove_prefix(parameter.size());
+            if (parameter.starts_with("token="sv) && parameter.size() > 6) {
+                return parameter.substr(6);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Series of one route, created up front so that handling a request does not touch the registry
+    struct RouteMetrics {
+        util::Counter &requests;
+        util::Histogram &duration;
+    };
+
+    static RouteMetrics MakeRouteMetrics(std::string_view route);
+
+    // Responding to a request: the callback keeps everything needed to finish the response
+    template <typename Send, typename Request>
+    auto Finish(const RouteMetrics &route, Send &&send, const Request &request) const {
+        return [this, &route, send = std::forward<Send>(send), version = request.version(),
+                keep_alive = request.keep_alive(), start_ts = std::chrono::steady_clock::now()](Response &&response) {
+            auto elapsed = std::chrono::steady_clock::now() - start_ts;
+            route.duration.Observe(elapsed);
+            CountResponse(response.code());
+            LogResponse(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), response.code(),
+                        response.content_type());
+
+            response.finalize(version, keep_alive);
+            response.send(send);
+        };
+    }
+
+    void CountResponse(int code) const {
+        auto index = static_cast<std::size_t>(code / 100);
+        responses_[index < responses_.size() ? index : 0]->Inc();
+    }
+
+    // Headers of a request that decide how a static file is sent
+    struct FileRequest {
+        std::string_view target;
+        std::string_view accept_encoding;
+        std::string_view if_none_match;
+        std::string_view if_modified_since;
+        std::string_view range;
+        std::string_view if_range;
+    };
+
     // Handle static files requests
-    Response get_file(std::string_view target) const;
+    Response get_file(const FileRequest &request) const;
+    // Metrics of the server in the text exposition format
+    Response get_metrics(http::verb method) const;
 
+    model::Game &game_;
+    api_handler::Strands &strands_;
+    api_handler::StateFeed &state_feed_;
     api_handler::APIHandler api_;
-    fs::path base_path_;
-    Strand api_strand_;
+    const static_content::StaticFiles &static_files_;
+
+    std::unordered_map<std::string, RouteMetrics, string_hash, std::equal_to<>> route_metrics_;
+    RouteMetrics static_route_;
+    RouteMetrics metrics_route_;
+    RouteMetrics state_feed_route_;
+    // By the class of the status code, 1xx to 5xx; anything else goes to the first one
+    std::array<util::Counter *, 6> responses_;
 };
 
 } // namespace request_handler
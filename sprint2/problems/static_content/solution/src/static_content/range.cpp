@@ -0,0 +1,84 @@
+#include "range.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+
+namespace static_content {
+
+namespace {
+
+std::string_view Trim(std::string_view value) {
+    auto begin = std::min(value.find_first_not_of(" \t"), value.size());
+    auto end = value.find_last_not_of(" \t");
+    return end == std::string_view::npos ? std::string_view{} : value.substr(begin, end - begin + 1);
+}
+
+std::optional<std::uint64_t> ParseNumber(std::string_view value) {
+    std::uint64_t number;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc{} || end != value.data() + value.size()) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+} // namespace
+
+RangeRequest ParseRange(std::string_view header, std::uint64_t size) {
+    constexpr std::string_view unit = "bytes=";
+    header = Trim(header);
+    if (!header.starts_with(unit)) {
+        return {};
+    }
+    header.remove_prefix(unit.size());
+
+    RangeRequest request;
+    std::size_t specs = 0;
+    while (!header.empty()) {
+        auto end = std::min(header.find(','), header.size());
+        auto spec = Trim(header.substr(0, end));
+        header.remove_prefix(std::min(end + 1, header.size()));
+        if (spec.empty()) {
+            continue;
+        }
+        if (++specs > MAX_RANGES) {
+            return {};
+        }
+
+        auto dash = spec.find('-');
+        if (dash == std::string_view::npos) {
+            return {};
+        }
+        auto first = spec.substr(0, dash), last = spec.substr(dash + 1);
+
+        if (first.empty()) {
+            // "-n" is the last n bytes
+            auto suffix = ParseNumber(last);
+            if (!suffix) {
+                return {};
+            }
+            if (*suffix > 0 && size > 0) {
+                request.ranges.push_back({size - std::min(*suffix, size), size - 1});
+            }
+            continue;
+        }
+
+        auto from = ParseNumber(first);
+        auto to = last.empty() ? std::optional<std::uint64_t>{UINT64_MAX} : ParseNumber(last);
+        if (!from || !to || *to < *from) {
+            return {};
+        }
+        if (*from < size) {
+            request.ranges.push_back({*from, std::min(*to, size - 1)});
+        }
+    }
+
+    if (specs == 0) {
+        return {};
+    }
+    request.status = request.ranges.empty() ? RangeRequest::Status::UNSATISFIABLE : RangeRequest::Status::PARTIAL;
+    return request;
+}
+
+} // namespace static_content
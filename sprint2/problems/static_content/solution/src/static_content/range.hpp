@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace static_content {
+
+// Inclusive byte range, as in "Content-Range: bytes first-last/size"
+struct ByteRange {
+    std::uint64_t first;
+    std::uint64_t last;
+
+    std::uint64_t Size() const { return last - first + 1; }
+};
+
+struct RangeRequest {
+    enum class Status {
+        // No usable Range header: the whole representation is sent
+        WHOLE,
+        PARTIAL,
+        // None of the ranges overlaps the representation, the answer is 416
+        UNSATISFIABLE
+    };
+
+    Status status = Status::WHOLE;
+    std::vector<ByteRange> ranges;
+};
+
+// More ranges than this in one request are treated as no ranges at all
+constexpr std::size_t MAX_RANGES = 16;
+
+// Resolve a "bytes=" Range header against a representation of the given size. Malformed headers and unknown
+// units are ignored, as RFC 9110 allows; ranges past the end are trimmed or dropped.
+RangeRequest ParseRange(std::string_view header, std::uint64_t size);
+
+} // namespace static_content
@@ -0,0 +1,450 @@
+#include "static_files.hpp"
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/beast/core/string.hpp>
+
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "util/compression.hpp"
+#include "util/filesystem.hpp"
+#include "util/http_date.hpp"
+#include "util/logging.hpp"
+#include "util/mime_type.hpp"
+
+#ifdef __linux__
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <sys/inotify.h>
+
+#include <array>
+#include <cerrno>
+#include <system_error>
+#endif
+
+namespace static_content {
+
+using namespace std::literals;
+
+namespace {
+
+// Catalog key of a target: "/" is index.html, "." and ".." segments are resolved. False if the target leaves the root.
+bool NormalizeTarget(std::string_view target, std::string &key) {
+    key.clear();
+    while (!target.empty()) {
+        if (target.front() == '/') {
+            target.remove_prefix(1);
+            continue;
+        }
+        auto end = std::min(target.find('/'), target.size());
+        auto segment = target.substr(0, end);
+        target.remove_prefix(end);
+
+        if (segment == "..") {
+            if (key.empty()) {
+                return false;
+            }
+            key.erase(key.rfind('/'));
+        } else if (segment != ".") {
+            key.push_back('/');
+            key.append(segment);
+        }
+    }
+    if (key.empty()) {
+        key = "/index.html";
+    }
+    return true;
+}
+
+util::SharedBody::value_type ReadFile(const fs::path &path, std::uintmax_t size) {
+    std::ifstream in{path, std::ios::binary};
+    std::string content(size, '\0');
+    if (!in.read(content.data(), static_cast<std::streamsize>(size))) {
+        return nullptr;
+    }
+    return std::make_shared<const std::string>(std::move(content));
+}
+
+// Quality values of the codings in an Accept-Encoding header, codings that are not listed get the value of "*"
+struct AcceptedEncodings {
+    double gzip = -1;
+    double brotli = -1;
+    double any = 0;
+
+    static AcceptedEncodings Parse(std::string_view header) {
+        using boost::beast::iequals;
+
+        AcceptedEncodings accepted;
+        while (!header.empty()) {
+            auto end = std::min(header.find(','), header.size());
+            auto item = header.substr(0, end);
+            header.remove_prefix(std::min(end + 1, header.size()));
+
+            auto params = std::min(item.find(';'), item.size());
+            auto coding = Trim(item.substr(0, params));
+            double quality = 1;
+            if (auto q = item.find("q=", params); q != std::string_view::npos) {
+                auto value = Trim(item.substr(q + 2));
+                if (std::from_chars(value.data(), value.data() + value.size(), quality).ec != std::errc{}) {
+                    quality = 0;
+                }
+            }
+
+            if (iequals(coding, "br")) {
+                accepted.brotli = quality;
+            } else if (iequals(coding, "gzip") || iequals(coding, "x-gzip")) {
+                accepted.gzip = quality;
+            } else if (coding == "*") {
+                accepted.any = quality;
+            }
+        }
+        return accepted;
+    }
+
+    double Brotli() const { return brotli < 0 ? any : brotli; }
+    double Gzip() const { return gzip < 0 ? any : gzip; }
+
+  private:
+    static std::string_view Trim(std::string_view value) {
+        auto begin = std::min(value.find_first_not_of(" \t"), value.size());
+        auto end = value.find_last_not_of(" \t");
+        return end == std::string_view::npos ? std::string_view{} : value.substr(begin, end - begin + 1);
+    }
+};
+
+// A representation is kept only if it saves at least a tenth of the size
+std::optional<StaticFiles::Encoded> Compress(std::optional<std::string> compressed, std::uintmax_t size) {
+    if (!compressed || compressed->size() >= size - size / 10) {
+        return std::nullopt;
+    }
+    auto compressed_size = compressed->size();
+    return StaticFiles::Encoded{{}, compressed_size, std::make_shared<const std::string>(std::move(*compressed)), {}};
+}
+
+// "<size>-<modification time>" in hex, a new version of a file gets a new tag without reading it
+void SetValidators(StaticFiles::File &file) {
+    const auto modified = std::chrono::file_clock::to_sys(file.last_write_time);
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(modified.time_since_epoch());
+
+    char buffer[40];
+    auto *end = buffer;
+    *end++ = '"';
+    end = std::to_chars(end, buffer + sizeof(buffer), file.size, 16).ptr;
+    *end++ = '-';
+    end = std::to_chars(end, buffer + sizeof(buffer), nanoseconds.count(), 16).ptr;
+    *end++ = '"';
+    file.etag.assign(buffer, end);
+
+    file.modified = std::chrono::floor<std::chrono::seconds>(modified);
+    file.last_modified = util::FormatHttpDate(file.modified);
+}
+
+// The tag of the file with the coding inserted before the closing quote
+std::string EncodedETag(std::string_view etag, std::string_view coding) {
+    std::string result{etag.substr(0, etag.size() - 1)};
+    result.push_back('-');
+    result.append(coding);
+    result.push_back('"');
+    return result;
+}
+
+} // namespace
+
+StaticFiles::Selected StaticFiles::File::Select(std::string_view accept_encoding) const {
+    if (HasEncodings() && !accept_encoding.empty()) {
+        auto accepted = AcceptedEncodings::Parse(accept_encoding);
+        const double brotli_quality = brotli ? accepted.Brotli() : 0;
+        const double gzip_quality = gzip ? accepted.Gzip() : 0;
+        if (brotli_quality > 0 && brotli_quality >= gzip_quality) {
+            return {brotli->path, brotli->size, brotli->content, "br", brotli->etag};
+        }
+        if (gzip_quality > 0) {
+            return {gzip->path, gzip->size, gzip->content, "gzip", gzip->etag};
+        }
+    }
+    return {path, size, content, {}, etag};
+}
+
+#ifdef __linux__
+
+// Turns inotify events into catalog reloads. Events come in bursts when files are copied or deployed,
+// so a reload waits a little and covers every event that arrives meanwhile. The catalog is built on a thread of the
+// watcher: walking the tree, reading and compressing files on a thread of the io_context would stall the
+// connections it serves. Only the finished catalog is published on the strand.
+class StaticFiles::Watcher {
+  public:
+    explicit Watcher(StaticFiles &files)
+        : files_(files), strand_(net::make_strand(files.ioc_)), descriptor_(strand_), timer_(strand_) {
+        int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "inotify_init1");
+        }
+        descriptor_.assign(fd);
+    }
+
+    void Start() {
+        net::dispatch(strand_, [this] {
+            AddWatches();
+            Read();
+        });
+    }
+
+  private:
+    static constexpr auto RELOAD_DELAY = 100ms;
+
+    // inotify does not watch subdirectories, so every directory of the tree gets its own watch.
+    // Adding a watch twice only updates it.
+    void AddWatches() {
+        constexpr std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM |
+                                       IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_ONLYDIR;
+        const int fd = descriptor_.native_handle();
+        ::inotify_add_watch(fd, files_.root_.c_str(), mask);
+
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it{files_.root_, fs::directory_options::skip_permission_denied, ec}, end;
+             !ec && it != end; it.increment(ec)) {
+            std::error_code entry_ec;
+            if (it->is_directory(entry_ec)) {
+                ::inotify_add_watch(fd, it->path().c_str(), mask);
+            }
+        }
+    }
+
+    void Read() {
+        descriptor_.async_read_some(net::buffer(buffer_), [this](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                if (ec != net::error::operation_aborted) {
+                    util::LogError(ec.value(), ec.message(), "inotify"sv);
+                }
+                return;
+            }
+            // Which files have changed does not matter, the whole catalog is rebuilt
+            if (!reload_pending_) {
+                reload_pending_ = true;
+                timer_.expires_after(RELOAD_DELAY);
+                timer_.async_wait([this](boost::system::error_code ec) {
+                    reload_pending_ = false;
+                    if (!ec) {
+                        AddWatches();
+                        Rebuild();
+                    }
+                });
+            }
+            Read();
+        });
+    }
+
+    // One build at a time, changes made during it are picked up by another one right after it
+    void Rebuild() {
+        if (building_) {
+            rebuild_ = true;
+            return;
+        }
+        building_ = true;
+        net::post(builder_, [this] {
+            auto previous = std::atomic_load_explicit(&files_.catalog_, std::memory_order_acquire);
+            auto catalog = files_.Build(previous.get());
+            net::post(strand_, [this, catalog = std::move(catalog)]() mutable {
+                std::atomic_store_explicit(&files_.catalog_, std::move(catalog), std::memory_order_release);
+                building_ = false;
+                if (std::exchange(rebuild_, false)) {
+                    Rebuild();
+                }
+            });
+        });
+    }
+
+    StaticFiles &files_;
+    net::strand<net::io_context::executor_type> strand_;
+    net::posix::stream_descriptor descriptor_;
+    net::steady_timer timer_;
+    bool reload_pending_ = false;
+    bool building_ = false;
+    bool rebuild_ = false;
+    alignas(inotify_event) std::array<char, 4096> buffer_;
+    // Destroyed first, a build in progress is finished before the rest of the watcher goes
+    net::thread_pool builder_{1};
+};
+
+#else
+
+class StaticFiles::Watcher {
+  public:
+    explicit Watcher(StaticFiles &) {}
+
+    void Start() {}
+};
+
+#endif
+
+StaticFiles::StaticFiles(net::io_context &ioc, fs::path root, Limits limits)
+    : ioc_(ioc), root_(fs::weakly_canonical(root)), limits_(limits), catalog_(Build(nullptr)) {}
+
+StaticFiles::~StaticFiles() = default;
+
+StaticFiles::Lookup StaticFiles::Find(std::string_view target) const {
+    target = target.substr(0, target.find('?'));
+
+    // Most targets are already normal and are looked up as they are
+    thread_local std::string normalized;
+    std::string_view key = target;
+    if (target == "/"sv || target.find("/."sv) != std::string_view::npos ||
+        target.find("//"sv) != std::string_view::npos || !target.starts_with('/')) {
+        if (!NormalizeTarget(target, normalized)) {
+            return {Lookup::Status::INVALID_PATH, nullptr};
+        }
+        key = normalized;
+    }
+
+    auto catalog = std::atomic_load_explicit(&catalog_, std::memory_order_acquire);
+    auto it = catalog->find(key);
+    if (it == catalog->end()) {
+        return {Lookup::Status::NOT_FOUND, nullptr};
+    }
+    return {Lookup::Status::FOUND, std::shared_ptr<const File>{catalog, &it->second}};
+}
+
+void StaticFiles::Watch() {
+    if (!watcher_) {
+        watcher_ = std::make_unique<Watcher>(*this);
+        watcher_->Start();
+    }
+}
+
+// The watcher publishes its catalogs on its strand, a reload runs on the calling thread
+void StaticFiles::Reload() {
+    auto previous = std::atomic_load_explicit(&catalog_, std::memory_order_acquire);
+    std::atomic_store_explicit(&catalog_, Build(previous.get()), std::memory_order_release);
+}
+
+bool StaticFiles::IsCompressible(std::string_view mime_type) {
+    return mime_type.starts_with("text/") || mime_type == "application/javascript" ||
+           mime_type == "application/json" || mime_type == "application/xml" || mime_type == "application/wasm" ||
+           mime_type == "image/svg+xml";
+}
+
+std::shared_ptr<const StaticFiles::Catalog> StaticFiles::Build(const Catalog *previous) const {
+    auto catalog = std::make_shared<Catalog>();
+    std::vector<std::string> compress;
+    std::uintmax_t cached_total = 0;
+
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it{root_, fs::directory_options::skip_permission_denied, ec}, end;
+         !ec && it != end; it.increment(ec)) {
+        const auto &entry = *it;
+        std::error_code file_ec;
+        if (!entry.is_regular_file(file_ec)) {
+            continue;
+        }
+        // Symbolic links may only lead to files under the root
+        if (entry.is_symlink(file_ec) && !util::ValidatePath(fs::weakly_canonical(entry.path(), file_ec), root_)) {
+            continue;
+        }
+
+        File file;
+        file.path = entry.path();
+        file.mime_type = util::GetMimeType(file.path.extension().string());
+        file.size = entry.file_size(file_ec);
+        file.last_write_time = entry.last_write_time(file_ec);
+        if (file_ec) {
+            continue;
+        }
+        SetValidators(file);
+
+        auto key = "/"s + entry.path().lexically_relative(root_).generic_string();
+        // An unchanged file keeps its contents and representations from the previous catalog
+        if (previous) {
+            auto known = previous->find(key);
+            if (known != previous->end() && known->second.size == file.size &&
+                known->second.last_write_time == file.last_write_time) {
+                file = known->second;
+            }
+        }
+
+        // Contents taken from the previous catalog count against the budget the same as those read now
+        if (file.size > limits_.max_cached_file || cached_total + file.size > limits_.max_cached_total) {
+            file.content.reset();
+        } else if (!file.content) {
+            file.content = ReadFile(file.path, file.size);
+        }
+        cached_total += file.content ? file.size : 0;
+        if (IsCompressible(file.mime_type)) {
+            compress.push_back(key);
+        }
+        catalog->emplace(std::move(key), std::move(file));
+    }
+
+    // Precompressed siblings are looked up in the catalog, so this goes after the whole tree has been walked
+    for (const auto &key : compress) {
+        AddEncodings(*catalog, catalog->at(key), key, cached_total);
+    }
+    return catalog;
+}
+
+void StaticFiles::AddEncodings(Catalog &catalog, File &file, std::string_view key,
+                               std::uintmax_t &cached_total) const {
+    // A sibling older than the file has been left over from a previous version of it
+    auto sibling = [&](std::string_view suffix) -> std::optional<Encoded> {
+        auto it = catalog.find(std::string{key} + std::string{suffix});
+        if (it == catalog.end() || it->second.last_write_time < file.last_write_time) {
+            return std::nullopt;
+        }
+        return Encoded{it->second.path, it->second.size, it->second.content, EncodedETag(file.etag, suffix.substr(1))};
+    };
+    auto gzip = sibling(".gz");
+    auto brotli = sibling(".br");
+    if (gzip || brotli) {
+        file.gzip = std::move(gzip);
+        file.brotli = std::move(brotli);
+        return;
+    }
+
+    // Representations in memory take from the budget of cached files, those over it are not kept
+    auto in_memory = [](const std::optional<Encoded> &encoded) { return encoded && encoded->path.empty(); };
+    auto fit = [&](std::optional<Encoded> &encoded) {
+        if (!in_memory(encoded)) {
+            return;
+        }
+        if (cached_total + encoded->size > limits_.max_cached_total) {
+            encoded.reset();
+        } else {
+            cached_total += encoded->size;
+        }
+    };
+
+    // Representations compressed in memory for the same version of the file are still valid
+    if (in_memory(file.gzip) || in_memory(file.brotli)) {
+        fit(file.gzip);
+        fit(file.brotli);
+        return;
+    }
+    file.gzip.reset();
+    file.brotli.reset();
+    if (file.size > limits_.max_compressed_file) {
+        return;
+    }
+
+    // Quicker settings than the build step uses, this runs on every startup
+    auto data = file.content ? file.content : ReadFile(file.path, file.size);
+    if (data) {
+        file.gzip = Compress(util::Gzip(*data, 9), file.size);
+        file.brotli = Compress(util::Brotli(*data, 9), file.size);
+    }
+    fit(file.gzip);
+    fit(file.brotli);
+    if (file.gzip) {
+        file.gzip->etag = EncodedETag(file.etag, "gz");
+    }
+    if (file.brotli) {
+        file.brotli->etag = EncodedETag(file.etag, "br");
+    }
+}
+
+} // namespace static_content
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "util/shared_body.hpp"
+#include "util/string_hash.hpp"
+
+namespace static_content {
+
+namespace fs = std::filesystem;
+namespace net = boost::asio;
+
+// Catalog of the files under the www root. The tree is walked once and every path is resolved and checked against
+// the root at that time, so serving a request is a single hash lookup without touching the file system. Small files
+// are kept in memory. Compressible files also get gzip and brotli representations: the .gz and .br files next to
+// them if they are up to date (see tools/precompress_static.cpp), otherwise compressed while the catalog is built.
+// Validators for conditional requests are made from the size and the modification time when the catalog is built.
+// The catalog is immutable and is replaced as a whole when the root changes.
+class StaticFiles {
+  public:
+    struct Limits {
+        // Files up to this size are read into memory, larger ones are sent from disk
+        std::uintmax_t max_cached_file = 256 * 1024;
+        // Total size of the files and compressed representations kept in memory
+        std::uintmax_t max_cached_total = 64 * 1024 * 1024;
+        // Files up to this size without precompressed siblings are compressed in memory when the catalog is built
+        std::uintmax_t max_compressed_file = 8 * 1024 * 1024;
+    };
+
+    // Compressed representation of a file, in memory or in a file of its own
+    struct Encoded {
+        fs::path path;
+        std::uintmax_t size = 0;
+        util::SharedBody::value_type content;
+        // Tag of the file with the coding appended, every representation needs a tag of its own
+        std::string etag;
+    };
+
+    // What to send for a request: the file itself or one of its compressed representations
+    struct Selected {
+        const fs::path &path;
+        std::uintmax_t size;
+        const util::SharedBody::value_type &content;
+        // Value of Content-Encoding, empty for the file as it is
+        std::string_view encoding;
+        std::string_view etag;
+    };
+
+    struct File {
+        fs::path path;
+        std::string_view mime_type;
+        std::uintmax_t size = 0;
+        fs::file_time_type last_write_time;
+        // Strong tag made of the size and the modification time, the contents are never hashed
+        std::string etag;
+        // Modification time as Last-Modified sends it, to the second
+        std::chrono::sys_seconds modified;
+        std::string last_modified;
+        // Contents of a cached file, null for files sent from disk
+        util::SharedBody::value_type content;
+        std::optional<Encoded> gzip;
+        std::optional<Encoded> brotli;
+
+        // Responses for files with compressed representations depend on Accept-Encoding and must say so in Vary
+        bool HasEncodings() const { return gzip || brotli; }
+
+        // Best representation the client accepts, preferring brotli to gzip when it accepts both equally
+        Selected Select(std::string_view accept_encoding) const;
+    };
+
+    struct Lookup {
+        enum class Status { FOUND, NOT_FOUND, INVALID_PATH };
+
+        Status status;
+        // Keeps its catalog alive, so the file stays valid after a reload
+        std::shared_ptr<const File> file;
+    };
+
+    StaticFiles(net::io_context &ioc, fs::path root, Limits limits);
+    StaticFiles(net::io_context &ioc, fs::path root) : StaticFiles(ioc, std::move(root), Limits{}) {}
+    ~StaticFiles();
+
+    StaticFiles(const StaticFiles &) = delete;
+    StaticFiles &operator=(const StaticFiles &) = delete;
+
+    // Look up the file for a request target, "/" means index.html. Targets leaving the root are invalid.
+    Lookup Find(std::string_view target) const;
+
+    // Rebuild the catalog whenever something changes under the root. Uses inotify, elsewhere it does nothing.
+    // The catalog is rebuilt on a thread of its own, not on the io_context.
+    void Watch();
+
+    // Walk the root again and publish the new catalog, on the calling thread
+    void Reload();
+
+    // Whether files of the type are worth compressing
+    static bool IsCompressible(std::string_view mime_type);
+
+  private:
+    using Catalog = std::unordered_map<std::string, File, string_hash, std::equal_to<>>;
+
+    class Watcher;
+
+    // Files that have not changed since the previous catalog are taken from it as they are
+    std::shared_ptr<const Catalog> Build(const Catalog *previous) const;
+    // Representations compressed in memory are added to cached_total
+    void AddEncodings(Catalog &catalog, File &file, std::string_view key, std::uintmax_t &cached_total) const;
+
+    net::io_context &ioc_;
+    fs::path root_;
+    Limits limits_;
+    // Accessed with std::atomic_load and std::atomic_store only
+    std::shared_ptr<const Catalog> catalog_;
+    std::unique_ptr<Watcher> watcher_;
+};
+
+} // namespace static_content
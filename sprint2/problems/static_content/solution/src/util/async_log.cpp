@@ -0,0 +1,218 @@
+#include "async_log.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace util {
+
+namespace json = boost::json;
+
+using namespace std::literals;
+
+LogRecord::LogRecord(Kind kind, std::int64_t first, std::int64_t second,
+                     std::initializer_list<std::string_view> strings)
+    : kind(kind), timestamp(boost::posix_time::microsec_clock::local_time()), numbers{first, second} {
+    std::size_t used = 0;
+    for (auto string : strings) {
+        if (string_count == MAX_STRINGS) {
+            break;
+        }
+        const auto size = std::min(string.size(), TEXT_SIZE - used);
+        std::memcpy(text + used, string.data(), size);
+        string_sizes[string_count++] = static_cast<std::uint16_t>(size);
+        used += size;
+    }
+}
+
+std::string_view LogRecord::String(std::size_t index) const {
+    if (index >= string_count) {
+        return {};
+    }
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < index; ++i) {
+        offset += string_sizes[i];
+    }
+    return {text + offset, string_sizes[index]};
+}
+
+// Ring buffer with one producer, the thread that owns it, and one consumer, the writer. Each side keeps its index
+// on its own cache line and publishes it with a release store.
+class AsyncLog::Queue {
+  public:
+    explicit Queue(std::size_t capacity)
+        : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+          records_(std::make_unique<LogRecord[]>(capacity_)) {}
+
+    bool TryPush(const LogRecord &record) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == capacity_) {
+                return false;
+            }
+        }
+        records_[tail & (capacity_ - 1)] = record;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Fn>
+    bool ConsumeAll(Fn &&fn) {
+        auto head = head_.load(std::memory_order_relaxed);
+        const auto tail = tail_.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        for (; head != tail; ++head) {
+            fn(records_[head & (capacity_ - 1)]);
+        }
+        head_.store(head, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    const std::size_t capacity_;
+    std::unique_ptr<LogRecord[]> records_;
+
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    // Last head seen by the producer, so it reads the consumer's line only when the queue looks full
+    std::uint64_t head_cache_ = 0;
+};
+
+namespace {
+
+std::atomic<std::uint64_t> next_log_id{1};
+
+struct ThreadQueue {
+    std::uint64_t log_id = 0;
+    void *queue = nullptr;
+};
+
+thread_local ThreadQueue this_thread_queue;
+
+void AppendLine(std::string &out, const boost::posix_time::ptime &timestamp, std::string_view message,
+                json::value data) {
+    json::value value = {{"timestamp", to_iso_extended_string(timestamp)}, {"message", message}, {"data", data}};
+    out.append(json::serialize(value));
+    out.push_back('\n');
+}
+
+} // namespace
+
+AsyncLog::AsyncLog(std::ostream &out, const AsyncLogOptions &options)
+    : out_(out), options_(options), id_(next_log_id++),
+      writer_([this](std::stop_token stop) { Run(std::move(stop)); }) {}
+
+AsyncLog::~AsyncLog() {
+    writer_.request_stop();
+    writer_.join();
+}
+
+bool AsyncLog::Push(const LogRecord &record) {
+    auto &queue = ThisThreadQueue();
+    if (queue.TryPush(record)) {
+        return true;
+    }
+    if (options_.overflow == LogOverflow::DROP) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    wake_.notify_one();
+    while (!queue.TryPush(record)) {
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+AsyncLog::Queue &AsyncLog::ThisThreadQueue() {
+    if (this_thread_queue.log_id != id_) {
+        std::lock_guard lock{mutex_};
+        auto &queue = queues_.emplace_back(std::make_unique<Queue>(options_.queue_size));
+        this_thread_queue = {id_, queue.get()};
+        queue_count_.store(queues_.size(), std::memory_order_release);
+    }
+    return *static_cast<Queue *>(this_thread_queue.queue);
+}
+
+void AsyncLog::Format(const LogRecord &record, std::string &out) {
+    using Kind = LogRecord::Kind;
+    switch (record.kind) {
+    case Kind::START:
+        AppendLine(out, record.timestamp, "server started"sv,
+                   {{"address", record.String(0)}, {"port", record.numbers[0]}});
+        break;
+    case Kind::EXIT:
+        if (record.string_count == 0) {
+            AppendLine(out, record.timestamp, "server exited"sv, {{"code", record.numbers[0]}});
+        } else {
+            AppendLine(out, record.timestamp, "server exited"sv,
+                       {{"code", record.numbers[0]}, {"exception", record.String(0)}});
+        }
+        break;
+    case Kind::REQUEST:
+        AppendLine(out, record.timestamp, "request received"sv,
+                   {{"address", record.String(0)}, {"uri", record.String(1)}, {"method", record.String(2)}});
+        break;
+    case Kind::RESPONSE:
+        AppendLine(out, record.timestamp, "response sent"sv,
+                   {{"response_time", record.numbers[0]},
+                    {"code", record.numbers[1]},
+                    {"content_type", record.String(0)}});
+        break;
+    case Kind::ERROR:
+        AppendLine(out, record.timestamp, "error"sv,
+                   {{"code", record.numbers[0]}, {"text", record.String(0)}, {"where", record.String(1)}});
+        break;
+    }
+}
+
+bool AsyncLog::Drain() {
+    if (auto count = queue_count_.load(std::memory_order_acquire); count != drained_.size()) {
+        std::lock_guard lock{mutex_};
+        drained_.clear();
+        for (auto &queue : queues_) {
+            drained_.push_back(queue.get());
+        }
+    }
+
+    bool any = false;
+    for (auto *queue : drained_) {
+        any |= queue->ConsumeAll([this](const LogRecord &record) { Format(record, batch_); });
+    }
+
+    if (auto dropped = Dropped(); dropped != reported_dropped_) {
+        AppendLine(batch_, boost::posix_time::microsec_clock::local_time(), "log records dropped"sv,
+                   {{"count", dropped - reported_dropped_}});
+        reported_dropped_ = dropped;
+        any = true;
+    }
+    return any;
+}
+
+void AsyncLog::Run(std::stop_token stop) {
+    auto flush = [this] {
+        out_.write(batch_.data(), static_cast<std::streamsize>(batch_.size()));
+        out_.flush();
+        batch_.clear();
+    };
+
+    while (!stop.stop_requested()) {
+        if (Drain()) {
+            flush();
+            continue;
+        }
+        std::unique_lock lock{mutex_};
+        wake_.wait_for(lock, stop, options_.flush_interval, [] { return false; });
+    }
+    // Records pushed before the log is destroyed are still written
+    if (Drain()) {
+        flush();
+    }
+}
+
+} // namespace util
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// What a thread does when its queue of log records is full
+enum class LogOverflow {
+    // Lose the record, the writer reports how many were lost
+    DROP,
+    // Wait for the writer to make room
+    BLOCK,
+};
+
+struct AsyncLogOptions {
+    // Records per thread, rounded up to a power of two
+    std::size_t queue_size = 4096;
+    LogOverflow overflow = LogOverflow::DROP;
+    // How long the writer sleeps when there is nothing to write
+    std::chrono::milliseconds flush_interval{10};
+};
+
+// One line of the log, copied by value into the queue of the thread that logs it. Strings longer than the record
+// can hold are cut, so a record never allocates.
+struct LogRecord {
+    enum class Kind : std::uint8_t { START, EXIT, REQUEST, RESPONSE, ERROR };
+
+    static constexpr std::size_t MAX_STRINGS = 3;
+    static constexpr std::size_t TEXT_SIZE = 464;
+
+    LogRecord() = default;
+    LogRecord(Kind kind, std::int64_t first, std::int64_t second, std::initializer_list<std::string_view> strings);
+
+    std::string_view String(std::size_t index) const;
+
+    Kind kind = Kind::START;
+    std::uint8_t string_count = 0;
+    std::uint16_t string_sizes[MAX_STRINGS] = {};
+    boost::posix_time::ptime timestamp;
+    std::int64_t numbers[2] = {};
+    char text[TEXT_SIZE];
+};
+
+// Log records are formatted and written by a background thread. Every thread that logs gets its own
+// single-producer queue, so logging on the request path is a copy into a ring buffer without locks or
+// allocations; the writer drains all queues into one buffer and writes it out at once.
+class AsyncLog {
+  public:
+    AsyncLog(std::ostream &out, const AsyncLogOptions &options = {});
+    // Writes out everything queued before returning
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog &) = delete;
+    AsyncLog &operator=(const AsyncLog &) = delete;
+
+    // May be called from any thread. Returns false if the record was dropped.
+    bool Push(const LogRecord &record);
+
+    std::uint64_t Dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+    // JSON line of a record, in the format of LogFormatter
+    static void Format(const LogRecord &record, std::string &out);
+
+  private:
+    class Queue;
+
+    Queue &ThisThreadQueue();
+    void Run(std::stop_token stop);
+    // Format every record queued so far into batch_, true if there were any
+    bool Drain();
+
+    std::ostream &out_;
+    const AsyncLogOptions options_;
+    // Tells the thread local queue pointers of different logs apart
+    const std::uint64_t id_;
+
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+    // Queues are only added, under the lock. The writer copies the pointers when queue_count_ changes.
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<std::size_t> queue_count_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    // Used by the writer only
+    std::vector<Queue *> drained_;
+    std::uint64_t reported_dropped_ = 0;
+    std::string batch_;
+
+    std::jthread writer_;
+};
+
+} // namespace util
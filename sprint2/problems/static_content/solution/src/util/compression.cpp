@@ -0,0 +1,42 @@
+#include "compression.hpp"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+namespace util {
+
+std::optional<std::string> Gzip(std::string_view data, int level) {
+    z_stream stream{};
+    // 16 added to the window bits asks zlib for the gzip wrapper instead of the zlib one
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::nullopt;
+    }
+
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    const int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+std::optional<std::string> Brotli(std::string_view data, int quality) {
+    std::string out(BrotliEncoderMaxCompressedSize(data.size()), '\0');
+    auto size = out.size();
+    if (out.empty() || !BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                                              reinterpret_cast<const std::uint8_t *>(data.data()), &size,
+                                              reinterpret_cast<std::uint8_t *>(out.data()))) {
+        return std::nullopt;
+    }
+    out.resize(size);
+    return out;
+}
+
+} // namespace util
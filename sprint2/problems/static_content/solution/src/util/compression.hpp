@@ -0,0 +1,13 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Whole-buffer compression for precompressed static content, nullopt if the encoder fails
+std::optional<std::string> Gzip(std::string_view data, int level = 9);
+std::optional<std::string> Brotli(std::string_view data, int quality = 11);
+
+} // namespace util
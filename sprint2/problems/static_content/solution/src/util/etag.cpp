@@ -0,0 +1,51 @@
+#include "etag.hpp"
+
+#include <cstdint>
+
+namespace util {
+
+namespace {
+
+std::string_view Trim(std::string_view value) {
+    auto begin = value.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+}
+
+std::string_view Opaque(std::string_view tag) { return tag.starts_with("W/") ? tag.substr(2) : tag; }
+
+} // namespace
+
+std::string MakeETag(std::string_view body) {
+    // FNV-1a does not depend on the process, so tags stay valid across restarts with the same data
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : body) {
+        hash = (hash ^ c) * 0x100000001b3ull;
+    }
+
+    constexpr char digits[] = "0123456789abcdef";
+    std::string etag(18, '"');
+    for (int i = 16; i > 0; --i, hash >>= 4) {
+        etag[i] = digits[hash & 0xf];
+    }
+    return etag;
+}
+
+bool ETagMatches(std::string_view if_none_match, std::string_view etag) {
+    if (Trim(if_none_match) == "*") {
+        return true;
+    }
+    const auto opaque = Opaque(etag);
+    while (!if_none_match.empty()) {
+        auto end = if_none_match.find(',');
+        if (Opaque(Trim(if_none_match.substr(0, end))) == opaque) {
+            return true;
+        }
+        if_none_match.remove_prefix(end == std::string_view::npos ? if_none_match.size() : end + 1);
+    }
+    return false;
+}
+
+} // namespace util
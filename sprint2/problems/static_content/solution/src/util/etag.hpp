@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Strong entity tag of a body, quoted as it goes into the ETag header
+std::string MakeETag(std::string_view body);
+
+// Whether an If-None-Match header value matches the tag, with the weak comparison RFC 9110 asks for
+bool ETagMatches(std::string_view if_none_match, std::string_view etag);
+
+} // namespace util
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+// Memory for the completion handlers of a chain of asynchronous operations that never overlaps itself, such as the
+// writes of a connection. A composed operation keeps at most a couple of intermediate operations alive at once
+// (a socket write and the timeout of the stream), so a few blocks cover it and the steady state does not touch the
+// heap. Larger or extra requests fall back to operator new. Must only be used from one strand.
+class HandlerMemory {
+  public:
+    HandlerMemory() = default;
+    HandlerMemory(const HandlerMemory &) = delete;
+    HandlerMemory &operator=(const HandlerMemory &) = delete;
+
+    void *Allocate(std::size_t size) {
+        if (size <= BLOCK_SIZE) {
+            for (auto &block : blocks_) {
+                if (!block.in_use) {
+                    block.in_use = true;
+                    return block.storage;
+                }
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void Deallocate(void *pointer) noexcept {
+        for (auto &block : blocks_) {
+            if (pointer == block.storage) {
+                block.in_use = false;
+                return;
+            }
+        }
+        ::operator delete(pointer);
+    }
+
+  private:
+    static constexpr std::size_t BLOCK_SIZE = 1024;
+
+    struct Block {
+        alignas(std::max_align_t) unsigned char storage[BLOCK_SIZE];
+        bool in_use = false;
+    };
+
+    std::array<Block, 2> blocks_;
+};
+
+template <typename T>
+class HandlerAllocator {
+  public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory &memory) noexcept : memory_(&memory) {}
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U> &other) noexcept : memory_(other.memory_) {}
+
+    T *allocate(std::size_t n) const { return static_cast<T *>(memory_->Allocate(sizeof(T) * n)); }
+    void deallocate(T *pointer, std::size_t) const noexcept { memory_->Deallocate(pointer); }
+
+    template <typename U>
+    bool operator==(const HandlerAllocator<U> &other) const noexcept {
+        return memory_ == other.memory_;
+    }
+
+  private:
+    template <typename>
+    friend class HandlerAllocator;
+
+    HandlerMemory *memory_;
+};
+
+// Completion handler whose associated allocator takes the memory of the operations from a HandlerMemory
+template <typename Handler>
+class MemoryBoundHandler {
+  public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    MemoryBoundHandler(HandlerMemory &memory, Handler handler) : memory_(&memory), handler_(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type{*memory_}; }
+
+    template <typename... Args>
+    void operator()(Args &&...args) {
+        handler_(std::forward<Args>(args)...);
+    }
+
+  private:
+    HandlerMemory *memory_;
+    Handler handler_;
+};
+
+template <typename Handler>
+MemoryBoundHandler<std::decay_t<Handler>> BindHandlerMemory(HandlerMemory &memory, Handler &&handler) {
+    return {memory, std::forward<Handler>(handler)};
+}
+
+} // namespace util
@@ -0,0 +1,31 @@
+#include "http_date.hpp"
+
+#include <ctime>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+
+namespace util {
+
+std::string FormatHttpDate(std::chrono::sys_seconds time) {
+    const std::time_t seconds = time.time_since_epoch().count();
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+
+    char buffer[32];
+    auto size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buffer, size);
+}
+
+std::optional<std::chrono::sys_seconds> ParseHttpDate(std::string_view date) {
+    std::tm tm{};
+    std::istringstream in{std::string{date}};
+    in.imbue(std::locale::classic());
+    in >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S GMT");
+    if (in.fail()) {
+        return std::nullopt;
+    }
+    return std::chrono::sys_seconds{std::chrono::seconds{timegm(&tm)}};
+}
+
+} // namespace util
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// IMF-fixdate used by Last-Modified and If-Modified-Since: "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string FormatHttpDate(std::chrono::sys_seconds time);
+
+// Only the IMF-fixdate form is understood, the obsolete ones give nullopt like any other malformed date
+std::optional<std::chrono::sys_seconds> ParseHttpDate(std::string_view date);
+
+} // namespace util
@@ -0,0 +1,98 @@
+#include "json_writer.hpp"
+
+#include <charconv>
+
+namespace util {
+
+namespace {
+
+void WriteEscaped(std::string &out, std::string_view value) {
+    constexpr char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    std::size_t plain = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const auto c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Runs of characters that need no escaping are copied at once
+        out.append(value.substr(plain, i - plain));
+        plain = i + 1;
+        switch (c) {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default:
+            out.append("\\u00");
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 0xf]);
+        }
+    }
+    out.append(value.substr(plain));
+    out.push_back('"');
+}
+
+template <typename T>
+void WriteNumber(std::string &out, T value) {
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+}
+
+} // namespace
+
+JsonWriter &JsonWriter::Key(std::string_view key) {
+    Separate();
+    WriteEscaped(out_, key);
+    out_.push_back(':');
+    first_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::Key(std::uint64_t key) {
+    Separate();
+    out_.push_back('"');
+    WriteNumber(out_, key);
+    out_.append("\":");
+    first_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::String(std::string_view value) {
+    Separate();
+    WriteEscaped(out_, value);
+    return *this;
+}
+
+// Shortest representation that reads back to the same double
+JsonWriter &JsonWriter::Number(double value) {
+    Separate();
+    WriteNumber(out_, value);
+    return *this;
+}
+
+JsonWriter &JsonWriter::Number(std::uint64_t value) {
+    Separate();
+    WriteNumber(out_, value);
+    return *this;
+}
+
+JsonWriter &JsonWriter::Bool(bool value) {
+    Separate();
+    out_.append(value ? "true" : "false");
+    return *this;
+}
+
+} // namespace util
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Writes JSON text straight into a string, without building a json::value first. The caller is responsible for
+// the structure: every key is followed by exactly one value, and objects and arrays are closed in order.
+class JsonWriter {
+  public:
+    explicit JsonWriter(std::string &out) : out_(out) {}
+
+    JsonWriter &BeginObject() { return Open('{'); }
+    JsonWriter &EndObject() { return Close('}'); }
+    JsonWriter &BeginArray() { return Open('['); }
+    JsonWriter &EndArray() { return Close(']'); }
+
+    JsonWriter &Key(std::string_view key);
+    // Numeric keys, such as player ids, are written without a temporary string
+    JsonWriter &Key(std::uint64_t key);
+
+    JsonWriter &String(std::string_view value);
+    JsonWriter &Number(double value);
+    JsonWriter &Number(std::uint64_t value);
+    JsonWriter &Bool(bool value);
+
+  private:
+    JsonWriter &Open(char bracket) {
+        Separate();
+        out_.push_back(bracket);
+        first_ = true;
+        return *this;
+    }
+
+    JsonWriter &Close(char bracket) {
+        out_.push_back(bracket);
+        first_ = false;
+        return *this;
+    }
+
+    // Values in a row are separated by commas, the value after a key is not
+    void Separate() {
+        if (!first_) {
+            out_.push_back(',');
+        }
+        first_ = false;
+    }
+
+    std::string &out_;
+    bool first_ = true;
+};
+
+} // namespace util
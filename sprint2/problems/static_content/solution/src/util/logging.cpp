@@ -6,6 +6,9 @@
 #include <boost/log/trivial.hpp>
 #include <boost/log/utility/manipulators/add_value.hpp>
 
+#include <atomic>
+#include <memory>
+
 namespace logging = boost::log;
 namespace json = boost::json;
 
@@ -14,6 +17,35 @@ BOOST_LOG_ATTRIBUTE_KEYWORD(timestamp, "TimeStamp", boost::posix_time::ptime)
 
 namespace util {
 
+namespace {
+
+using Kind = LogRecord::Kind;
+
+std::atomic<bool> log_enabled{true};
+std::unique_ptr<AsyncLog> async_log_owner;
+std::atomic<AsyncLog *> async_log{nullptr};
+
+// Queue the record if the log is asynchronous. Returns false if the caller has to write it itself.
+bool Enqueue(Kind kind, std::int64_t first, std::int64_t second, std::initializer_list<std::string_view> strings) {
+    if (auto *log = async_log.load(std::memory_order_acquire)) {
+        log->Push(LogRecord{kind, first, second, strings});
+        return true;
+    }
+    return !log_enabled.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+void SetLogMode(LogMode mode, std::ostream &out, const AsyncLogOptions &options) {
+    async_log.store(nullptr, std::memory_order_release);
+    async_log_owner.reset();
+    log_enabled.store(mode != LogMode::OFF, std::memory_order_relaxed);
+    if (mode == LogMode::ASYNC) {
+        async_log_owner = std::make_unique<AsyncLog>(out, options);
+        async_log.store(async_log_owner.get(), std::memory_order_release);
+    }
+}
+
 void LogFormatter(const logging::record_view &rec, logging::formatting_ostream &stream) {
     json::value value = {{"timestamp", to_iso_extended_string(*rec[timestamp])},
                          {"message", *rec[logging::expressions::smessage]},
@@ -22,31 +54,49 @@ void LogFormatter(const logging::record_view &rec, logging::formatting_ostream &
 }
 
 void LogStart(std::string_view address, unsigned int port) {
+    if (Enqueue(Kind::START, port, 0, {address})) {
+        return;
+    }
     boost::json::value custom_data{{"address", address}, {"port", port}};
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "server started";
 }
 
 void LogExit(int code) {
+    if (Enqueue(Kind::EXIT, code, 0, {})) {
+        return;
+    }
     boost::json::value custom_data{{"code", code}};
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "server exited";
 }
 
 void LogExit(int code, std::string_view exception) {
+    if (Enqueue(Kind::EXIT, code, 0, {exception})) {
+        return;
+    }
     boost::json::value custom_data{{"code", code}, {"exception", exception}};
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "server exited";
 }
 
 void LogRequest(std::string_view address, std::string_view uri, std::string_view method) {
+    if (Enqueue(Kind::REQUEST, 0, 0, {address, uri, method})) {
+        return;
+    }
     boost::json::value custom_data{{"address", address}, {"uri", uri}, {"method", method}};
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "request received";
 }
 
 void LogResponse(int response_time, int code, std::string_view content_type) {
+    if (Enqueue(Kind::RESPONSE, response_time, code, {content_type})) {
+        return;
+    }
     boost::json::value custom_data{{"response_time", response_time}, {"code", code}, {"content_type", content_type}};
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "response sent";
 }
 
 void LogError(int code, std::string_view text, std::string_view where) {
+    if (Enqueue(Kind::ERROR, code, 0, {text, where})) {
+        return;
+    }
     boost::json::value custom_data{{"code", code}, {"text", text}, {"where", where}};
     BOOST_LOG_TRIVIAL(info) << boost::log::add_value(additional_data, custom_data) << "error";
 }
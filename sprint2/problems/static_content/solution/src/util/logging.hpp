@@ -3,8 +3,26 @@
 #include <boost/log/core/record_view.hpp>
 #include <boost/log/utility/formatting_ostream_fwd.hpp>
 
+#include <iostream>
+#include <ostream>
+#include <string_view>
+
+#include "async_log.hpp"
+
 namespace util {
 
+enum class LogMode {
+    // Every record is formatted and written through Boost.Log on the thread that logs it
+    SYNC,
+    // Records are queued and written in batches by a background thread
+    ASYNC,
+    OFF,
+};
+
+// Choose where the Log* functions write. Not thread safe: call it before the server starts and after it stops.
+// Leaving ASYNC, or exiting the program, writes out the records still queued.
+void SetLogMode(LogMode mode, std::ostream &out = std::clog, const AsyncLogOptions &options = {});
+
 void LogFormatter(const boost::log::record_view &rec, boost::log::formatting_ostream &stream);
 
 void LogStart(std::string_view address, unsigned int port);
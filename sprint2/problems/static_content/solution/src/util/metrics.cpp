@@ -0,0 +1,229 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <type_traits>
+
+namespace util {
+
+using namespace std::literals;
+
+namespace metrics_detail {
+
+std::size_t ThisThreadShard() noexcept {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return shard;
+}
+
+} // namespace metrics_detail
+
+namespace {
+
+constexpr std::size_t VALUES_PER_LINE = metrics_detail::CACHE_LINE / sizeof(std::uint64_t);
+
+void AppendNumber(std::string &out, double value) {
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general);
+    out.append(buffer, end);
+}
+
+void AppendNumber(std::string &out, std::uint64_t value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+}
+
+void AppendNumber(std::string &out, std::int64_t value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+}
+
+// Label values escape backslashes, quotes and line breaks, help texts only backslashes and line breaks
+void AppendEscaped(std::string &out, std::string_view text, bool quotes) {
+    for (char c : text) {
+        if (c == '\\') {
+            out.append("\\\\"sv);
+        } else if (c == '\n') {
+            out.append("\\n"sv);
+        } else if (c == '"' && quotes) {
+            out.append("\\\""sv);
+        } else {
+            out.push_back(c);
+        }
+    }
+}
+
+std::string RenderLabels(const MetricLabels &labels) {
+    std::string out;
+    for (const auto &[name, value] : labels) {
+        if (!out.empty()) {
+            out.push_back(',');
+        }
+        out.append(name).append("=\""sv);
+        AppendEscaped(out, value, true);
+        out.push_back('"');
+    }
+    return out;
+}
+
+void AppendSeries(std::string &out, std::string_view name, std::string_view suffix, std::string_view labels,
+                  std::string_view extra_label = {}) {
+    out.append(name).append(suffix);
+    if (!labels.empty() || !extra_label.empty()) {
+        out.push_back('{');
+        out.append(labels);
+        if (!labels.empty() && !extra_label.empty()) {
+            out.push_back(',');
+        }
+        out.append(extra_label);
+        out.push_back('}');
+    }
+    out.push_back(' ');
+}
+
+void AppendValue(std::string &out, std::string_view name, std::string_view labels, const Counter &counter) {
+    AppendSeries(out, name, {}, labels);
+    AppendNumber(out, counter.Value());
+    out.push_back('\n');
+}
+
+void AppendValue(std::string &out, std::string_view name, std::string_view labels, const Gauge &gauge) {
+    AppendSeries(out, name, {}, labels);
+    AppendNumber(out, gauge.Value());
+    out.push_back('\n');
+}
+
+void AppendValue(std::string &out, std::string_view name, std::string_view labels, const Histogram &histogram) {
+    const auto snapshot = histogram.Collect();
+    const auto &bounds = histogram.GetBounds();
+    std::uint64_t cumulative = 0;
+    std::string le;
+    for (std::size_t i = 0; i < snapshot.buckets.size(); ++i) {
+        cumulative += snapshot.buckets[i];
+        le = "le=\""s;
+        if (i < bounds.size()) {
+            AppendNumber(le, bounds[i]);
+        } else {
+            le.append("+Inf"sv);
+        }
+        le.push_back('"');
+        AppendSeries(out, name, "_bucket"sv, labels, le);
+        AppendNumber(out, cumulative);
+        out.push_back('\n');
+    }
+    AppendSeries(out, name, "_sum"sv, labels);
+    AppendNumber(out, snapshot.sum_seconds);
+    out.push_back('\n');
+    AppendSeries(out, name, "_count"sv, labels);
+    AppendNumber(out, snapshot.count);
+    out.push_back('\n');
+}
+
+constexpr std::array<std::string_view, 3> TYPE_NAMES{"counter"sv, "gauge"sv, "histogram"sv};
+
+} // namespace
+
+std::uint64_t Counter::Value() const noexcept {
+    std::uint64_t value = 0;
+    for (const auto &shard : shards_) {
+        value += shard.value.load(std::memory_order_relaxed);
+    }
+    return value;
+}
+
+Histogram::Histogram(const Bounds &bounds)
+    : bounds_(bounds), lines_per_shard_((bounds.size() + 2 + VALUES_PER_LINE - 1) / VALUES_PER_LINE),
+      lines_(std::make_unique<Line[]>(lines_per_shard_ * metrics_detail::SHARDS)) {
+    if (!std::is_sorted(bounds_.begin(), bounds_.end())) {
+        throw std::invalid_argument{"histogram bounds must be ascending"};
+    }
+    for (double bound : bounds_) {
+        bounds_ns_.push_back(static_cast<std::uint64_t>(bound * 1e9));
+    }
+}
+
+const Histogram::Bounds &Histogram::LatencyBounds() {
+    static const Bounds bounds{0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 10};
+    return bounds;
+}
+
+Histogram::Snapshot Histogram::Collect() const {
+    Snapshot snapshot;
+    snapshot.buckets.resize(bounds_ns_.size() + 1);
+    std::uint64_t sum_ns = 0;
+    for (std::size_t i = 0; i < metrics_detail::SHARDS; ++i) {
+        const auto *shard = Shard(i);
+        for (std::size_t bucket = 0; bucket < snapshot.buckets.size(); ++bucket) {
+            snapshot.buckets[bucket] += shard[bucket].load(std::memory_order_relaxed);
+        }
+        sum_ns += shard[SumIndex()].load(std::memory_order_relaxed);
+    }
+    for (auto count : snapshot.buckets) {
+        snapshot.count += count;
+    }
+    snapshot.sum_seconds = static_cast<double>(sum_ns) / 1e9;
+    return snapshot;
+}
+
+template <typename T, typename... Args>
+T &MetricsRegistry::Get(std::string_view name, std::string_view help, const MetricLabels &labels, Args &&...args) {
+    constexpr std::size_t type = std::is_same_v<T, Counter> ? 0 : std::is_same_v<T, Gauge> ? 1 : 2;
+    auto rendered = RenderLabels(labels);
+
+    std::lock_guard lock{mutex_};
+    auto family = std::find_if(families_.begin(), families_.end(), [&](const auto &f) { return f.name == name; });
+    if (family == families_.end()) {
+        family = families_.insert(families_.end(), Family{std::string{name}, std::string{help}, type, {}});
+    } else if (family->type != type) {
+        throw std::logic_error{"metric "s + std::string{name} + " is already registered with another type"};
+    }
+
+    for (auto &series : family->series) {
+        if (series.labels == rendered) {
+            return *std::get<std::unique_ptr<T>>(series.metric);
+        }
+    }
+    auto metric = std::make_unique<T>(std::forward<Args>(args)...);
+    auto &result = *metric;
+    family->series.push_back(Series{std::move(rendered), std::move(metric)});
+    return result;
+}
+
+Counter &MetricsRegistry::GetCounter(std::string_view name, std::string_view help, const MetricLabels &labels) {
+    return Get<Counter>(name, help, labels);
+}
+
+Gauge &MetricsRegistry::GetGauge(std::string_view name, std::string_view help, const MetricLabels &labels) {
+    return Get<Gauge>(name, help, labels);
+}
+
+Histogram &MetricsRegistry::GetHistogram(std::string_view name, std::string_view help, const MetricLabels &labels,
+                                         const Histogram::Bounds &bounds) {
+    return Get<Histogram>(name, help, labels, bounds);
+}
+
+std::string MetricsRegistry::Expose() const {
+    std::string out;
+    std::lock_guard lock{mutex_};
+    for (const auto &family : families_) {
+        out.append("# HELP "sv).append(family.name).push_back(' ');
+        AppendEscaped(out, family.help, false);
+        out.append("\n# TYPE "sv).append(family.name).push_back(' ');
+        out.append(TYPE_NAMES[family.type]).push_back('\n');
+        for (const auto &series : family.series) {
+            std::visit([&](const auto &metric) { AppendValue(out, family.name, series.labels, *metric); },
+                       series.metric);
+        }
+    }
+    return out;
+}
+
+MetricsRegistry &Metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+} // namespace util
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace util {
+
+namespace metrics_detail {
+
+// Updates are spread over a few cache lines so that threads do not fight over one of them. Every thread picks
+// its shard once, readers sum all of them.
+constexpr std::size_t SHARDS = 16;
+constexpr std::size_t CACHE_LINE = 64;
+
+std::size_t ThisThreadShard() noexcept;
+
+} // namespace metrics_detail
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+class Counter {
+  public:
+    Counter() = default;
+    Counter(const Counter &) = delete;
+    Counter &operator=(const Counter &) = delete;
+
+    void Inc(std::uint64_t amount = 1) noexcept {
+        shards_[metrics_detail::ThisThreadShard()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Value() const noexcept;
+
+  private:
+    struct alignas(metrics_detail::CACHE_LINE) Shard {
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    std::array<Shard, metrics_detail::SHARDS> shards_;
+};
+
+// Value that goes up and down, such as the number of open connections. Changes are rare next to counters,
+// so it is a single atomic.
+class Gauge {
+  public:
+    Gauge() = default;
+    Gauge(const Gauge &) = delete;
+    Gauge &operator=(const Gauge &) = delete;
+
+    void Add(std::int64_t amount) noexcept { value_.fetch_add(amount, std::memory_order_relaxed); }
+    void Set(std::int64_t value) noexcept { value_.store(value, std::memory_order_relaxed); }
+    std::int64_t Value() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<std::int64_t> value_{0};
+};
+
+// Durations counted into fixed buckets by their upper bounds, plus the +Inf bucket and the total time.
+// An observation is a short scan over the bounds and two relaxed increments on the shard of the thread.
+class Histogram {
+  public:
+    using Bounds = std::vector<double>;
+
+    // Upper bounds in seconds, ascending
+    explicit Histogram(const Bounds &bounds);
+    Histogram(const Histogram &) = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    // Response times from half a millisecond to ten seconds
+    static const Bounds &LatencyBounds();
+
+    void Observe(std::chrono::nanoseconds duration) noexcept {
+        const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count()));
+        std::size_t bucket = 0;
+        while (bucket < bounds_ns_.size() && ns > bounds_ns_[bucket]) {
+            ++bucket;
+        }
+        auto *shard = Shard(metrics_detail::ThisThreadShard());
+        shard[bucket].fetch_add(1, std::memory_order_relaxed);
+        shard[SumIndex()].fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    struct Snapshot {
+        // Not cumulative, the last one is the +Inf bucket
+        std::vector<std::uint64_t> buckets;
+        std::uint64_t count = 0;
+        double sum_seconds = 0;
+    };
+
+    const Bounds &GetBounds() const noexcept { return bounds_; }
+    Snapshot Collect() const;
+
+  private:
+    struct alignas(metrics_detail::CACHE_LINE) Line {
+        std::atomic<std::uint64_t> values[metrics_detail::CACHE_LINE / sizeof(std::uint64_t)];
+    };
+
+    // Buckets, then the sum in nanoseconds
+    std::size_t SumIndex() const noexcept { return bounds_ns_.size() + 1; }
+
+    std::atomic<std::uint64_t> *Shard(std::size_t shard) const noexcept {
+        return lines_[shard * lines_per_shard_].values;
+    }
+
+    Bounds bounds_;
+    std::vector<std::uint64_t> bounds_ns_;
+    std::size_t lines_per_shard_;
+    std::unique_ptr<Line[]> lines_;
+};
+
+// Metrics of the process in the Prometheus text exposition format. Metrics are looked up or created once under
+// the lock and then updated through the returned reference, which stays valid for the life of the registry.
+class MetricsRegistry {
+  public:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+    // The same name and labels give the same metric. A name registered with another type throws std::logic_error.
+    Counter &GetCounter(std::string_view name, std::string_view help, const MetricLabels &labels = {});
+    Gauge &GetGauge(std::string_view name, std::string_view help, const MetricLabels &labels = {});
+    Histogram &GetHistogram(std::string_view name, std::string_view help, const MetricLabels &labels = {},
+                            const Histogram::Bounds &bounds = Histogram::LatencyBounds());
+
+    std::string Expose() const;
+
+  private:
+    using Metric = std::variant<std::unique_ptr<Counter>, std::unique_ptr<Gauge>, std::unique_ptr<Histogram>>;
+
+    struct Series {
+        // Rendered as in the exposition, k1="v1",k2="v2"
+        std::string labels;
+        Metric metric;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        std::size_t type;
+        std::vector<Series> series;
+    };
+
+    template <typename T, typename... Args>
+    T &Get(std::string_view name, std::string_view help, const MetricLabels &labels, Args &&...args);
+
+    mutable std::mutex mutex_;
+    std::vector<Family> families_;
+};
+
+// Registry of the server, /metrics shows it
+MetricsRegistry &Metrics();
+
+} // namespace util
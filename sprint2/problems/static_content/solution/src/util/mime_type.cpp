@@ -1,55 +1,117 @@
 #include "mime_type.hpp"
 
-#include <boost/beast/core/string.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 
 namespace util {
 
-// Return a reasonable mime type based on the extension of a file.
+namespace {
+
+using namespace std::literals;
+
+constexpr std::string_view DEFAULT_MIME_TYPE = "application/octet-stream"sv;
+
+// Lower-case extensions without the dot
+constexpr std::pair<std::string_view, std::string_view> MIME_TYPES[] = {
+    {"htm"sv, "text/html"sv},
+    {"html"sv, "text/html"sv},
+    {"css"sv, "text/css"sv},
+    {"txt"sv, "text/plain"sv},
+    {"js"sv, "application/javascript"sv},
+    {"mjs"sv, "application/javascript"sv},
+    {"json"sv, "application/json"sv},
+    {"map"sv, "application/json"sv},
+    {"xml"sv, "application/xml"sv},
+    {"wasm"sv, "application/wasm"sv},
+    {"png"sv, "image/png"sv},
+    {"jpg"sv, "image/jpeg"sv},
+    {"jpe"sv, "image/jpeg"sv},
+    {"jpeg"sv, "image/jpeg"sv},
+    {"gif"sv, "image/gif"sv},
+    {"bmp"sv, "image/bmp"sv},
+    {"ico"sv, "image/vnd.microsoft.icon"sv},
+    {"tiff"sv, "image/tiff"sv},
+    {"tif"sv, "image/tiff"sv},
+    {"svg"sv, "image/svg+xml"sv},
+    {"svgz"sv, "image/svg+xml"sv},
+    {"webp"sv, "image/webp"sv},
+    {"woff"sv, "font/woff"sv},
+    {"woff2"sv, "font/woff2"sv},
+};
+
+constexpr std::size_t TABLE_SIZE = 64;
+constexpr std::size_t MAX_EXTENSION = 5;
+
+constexpr char ToLower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+// FNV-1a over the lower-cased extension, the seed replaces the offset basis
+constexpr std::size_t Slot(std::string_view extension, std::uint32_t seed) {
+    std::uint32_t hash = seed;
+    for (char c : extension) {
+        hash = (hash ^ static_cast<unsigned char>(ToLower(c))) * 0x01000193u;
+    }
+    return (hash >> 16) & (TABLE_SIZE - 1);
+}
+
+constexpr bool IsPerfect(std::uint32_t seed) {
+    std::array<bool, TABLE_SIZE> used{};
+    for (const auto &[extension, mime_type] : MIME_TYPES) {
+        auto slot = Slot(extension, seed);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+// The first seed giving every extension a slot of its own
+constexpr std::uint32_t FindSeed() {
+    for (std::uint32_t seed = 0x811C9DC5u;; ++seed) {
+        if (IsPerfect(seed)) {
+            return seed;
+        }
+    }
+}
+
+constexpr std::uint32_t SEED = FindSeed();
+
+struct Entry {
+    std::string_view extension;
+    std::string_view mime_type = DEFAULT_MIME_TYPE;
+};
+
+constexpr std::array<Entry, TABLE_SIZE> MakeTable() {
+    std::array<Entry, TABLE_SIZE> table{};
+    for (const auto &[extension, mime_type] : MIME_TYPES) {
+        table[Slot(extension, SEED)] = {extension, mime_type};
+    }
+    return table;
+}
+
+constexpr auto TABLE = MakeTable();
+
+} // namespace
+
 std::string_view GetMimeType(std::string_view path) {
-    using boost::beast::iequals;
-    auto const ext = [&path] {
-        auto const pos = path.rfind(".");
-        if (pos == std::string_view::npos)
-            return std::string_view{};
-        return path.substr(pos);
-    }();
-    if (iequals(ext, ".htm"))
-        return "text/html";
-    if (iequals(ext, ".html"))
-        return "text/html";
-    if (iequals(ext, ".css"))
-        return "text/css";
-    if (iequals(ext, ".txt"))
-        return "text/plain";
-    if (iequals(ext, ".js"))
-        return "application/javascript";
-    if (iequals(ext, ".json"))
-        return "application/json";
-    if (iequals(ext, ".xml"))
-        return "application/xml";
-    if (iequals(ext, ".png"))
-        return "image/png";
-    if (iequals(ext, ".jpg"))
-        return "image/jpeg";
-    if (iequals(ext, ".jpe"))
-        return "image/jpeg";
-    if (iequals(ext, ".jpeg"))
-        return "image/jpeg";
-    if (iequals(ext, ".gif"))
-        return "image/gif";
-    if (iequals(ext, ".bmp"))
-        return "image/bmp";
-    if (iequals(ext, ".ico"))
-        return "image/vnd.microsoft.icon";
-    if (iequals(ext, ".tiff"))
-        return "image/tiff";
-    if (iequals(ext, ".tif"))
-        return "image/tiff";
-    if (iequals(ext, ".svg"))
-        return "image/svg+xml";
-    if (iequals(ext, ".svgz"))
-        return "image/svg+xml";
-    return "application/octet-stream";
+    auto const pos = path.rfind('.');
+    if (pos == std::string_view::npos || path.size() - pos - 1 > MAX_EXTENSION) {
+        return DEFAULT_MIME_TYPE;
+    }
+    auto const ext = path.substr(pos + 1);
+
+    const auto &entry = TABLE[Slot(ext, SEED)];
+    if (entry.extension.size() != ext.size()) {
+        return DEFAULT_MIME_TYPE;
+    }
+    for (std::size_t i = 0; i < ext.size(); ++i) {
+        if (ToLower(ext[i]) != entry.extension[i]) {
+            return DEFAULT_MIME_TYPE;
+        }
+    }
+    return entry.mime_type;
 }
 
-} // namespace util
\ No newline at end of file
+} // namespace util
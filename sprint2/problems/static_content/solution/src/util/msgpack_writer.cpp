@@ -0,0 +1,153 @@
+#include "msgpack_writer.hpp"
+
+#include <bit>
+#include <limits>
+
+namespace util {
+
+namespace {
+
+// Headers of the formats with the size or value in the first byte
+constexpr std::uint8_t FIXMAP = 0x80;
+constexpr std::uint8_t FIXARRAY = 0x90;
+constexpr std::uint8_t FIXSTR = 0xa0;
+
+constexpr std::uint8_t BOOL_FALSE = 0xc2;
+constexpr std::uint8_t BOOL_TRUE = 0xc3;
+constexpr std::uint8_t FLOAT32 = 0xca;
+constexpr std::uint8_t FLOAT64 = 0xcb;
+constexpr std::uint8_t UINT8 = 0xcc;
+constexpr std::uint8_t UINT16 = 0xcd;
+constexpr std::uint8_t UINT32 = 0xce;
+constexpr std::uint8_t UINT64 = 0xcf;
+constexpr std::uint8_t INT8 = 0xd0;
+constexpr std::uint8_t INT16 = 0xd1;
+constexpr std::uint8_t INT32 = 0xd2;
+constexpr std::uint8_t INT64 = 0xd3;
+constexpr std::uint8_t STR8 = 0xd9;
+constexpr std::uint8_t STR16 = 0xda;
+constexpr std::uint8_t STR32 = 0xdb;
+constexpr std::uint8_t ARRAY16 = 0xdc;
+constexpr std::uint8_t ARRAY32 = 0xdd;
+constexpr std::uint8_t MAP16 = 0xde;
+constexpr std::uint8_t MAP32 = 0xdf;
+
+template <typename T>
+void Store(char *out, T value) {
+    for (std::size_t i = sizeof(T); i-- > 0;) {
+        *out++ = static_cast<char>(value >> (i * 8));
+    }
+}
+
+} // namespace
+
+template <typename T>
+void MsgPackWriter::Append(std::uint8_t type, T value) {
+    char buffer[1 + sizeof(T)];
+    buffer[0] = static_cast<char>(type);
+    Store(buffer + 1, value);
+    out_.append(buffer, sizeof(buffer));
+}
+
+MsgPackWriter &MsgPackWriter::Map(std::uint32_t size) {
+    if (size < 16) {
+        out_.push_back(static_cast<char>(FIXMAP | size));
+    } else if (size <= std::numeric_limits<std::uint16_t>::max()) {
+        Append(MAP16, static_cast<std::uint16_t>(size));
+    } else {
+        Append(MAP32, size);
+    }
+    return *this;
+}
+
+MsgPackWriter &MsgPackWriter::Array(std::uint32_t size) {
+    if (size < 16) {
+        out_.push_back(static_cast<char>(FIXARRAY | size));
+    } else if (size <= std::numeric_limits<std::uint16_t>::max()) {
+        Append(ARRAY16, static_cast<std::uint16_t>(size));
+    } else {
+        Append(ARRAY32, size);
+    }
+    return *this;
+}
+
+std::size_t MsgPackWriter::BeginMap() {
+    const auto position = out_.size();
+    Append(MAP32, std::uint32_t{0});
+    return position;
+}
+
+MsgPackWriter &MsgPackWriter::EndMap(std::size_t position, std::uint32_t size) {
+    Store(out_.data() + position + 1, size);
+    return *this;
+}
+
+MsgPackWriter &MsgPackWriter::String(std::string_view value) {
+    const auto size = value.size();
+    if (size < 32) {
+        out_.push_back(static_cast<char>(FIXSTR | size));
+    } else if (size <= std::numeric_limits<std::uint8_t>::max()) {
+        Append(STR8, static_cast<std::uint8_t>(size));
+    } else if (size <= std::numeric_limits<std::uint16_t>::max()) {
+        Append(STR16, static_cast<std::uint16_t>(size));
+    } else {
+        Append(STR32, static_cast<std::uint32_t>(size));
+    }
+    out_.append(value);
+    return *this;
+}
+
+MsgPackWriter &MsgPackWriter::Uint(std::uint64_t value) {
+    if (value < 128) {
+        out_.push_back(static_cast<char>(value));
+    } else if (value <= std::numeric_limits<std::uint8_t>::max()) {
+        Append(UINT8, static_cast<std::uint8_t>(value));
+    } else if (value <= std::numeric_limits<std::uint16_t>::max()) {
+        Append(UINT16, static_cast<std::uint16_t>(value));
+    } else if (value <= std::numeric_limits<std::uint32_t>::max()) {
+        Append(UINT32, static_cast<std::uint32_t>(value));
+    } else {
+        Append(UINT64, value);
+    }
+    return *this;
+}
+
+MsgPackWriter &MsgPackWriter::Int(std::int64_t value) {
+    if (value >= 0) {
+        return Uint(static_cast<std::uint64_t>(value));
+    }
+    if (value >= -32) {
+        // Negative fixint
+        out_.push_back(static_cast<char>(value));
+    } else if (value >= std::numeric_limits<std::int8_t>::min()) {
+        Append(INT8, static_cast<std::uint8_t>(value));
+    } else if (value >= std::numeric_limits<std::int16_t>::min()) {
+        Append(INT16, static_cast<std::uint16_t>(value));
+    } else if (value >= std::numeric_limits<std::int32_t>::min()) {
+        Append(INT32, static_cast<std::uint32_t>(value));
+    } else {
+        Append(INT64, static_cast<std::uint64_t>(value));
+    }
+    return *this;
+}
+
+MsgPackWriter &MsgPackWriter::Number(double value) {
+    // Dogs standing still and on the middle lines of roads have whole coordinates and speeds
+    constexpr double INT_LIMIT = 1ll << 53;
+    if (value > -INT_LIMIT && value < INT_LIMIT && value == static_cast<double>(static_cast<std::int64_t>(value))) {
+        return Int(static_cast<std::int64_t>(value));
+    }
+    if (const auto narrow = static_cast<float>(value); static_cast<double>(narrow) == value) {
+        Append(FLOAT32, std::bit_cast<std::uint32_t>(narrow));
+    } else {
+        Append(FLOAT64, std::bit_cast<std::uint64_t>(value));
+    }
+    return *this;
+}
+
+MsgPackWriter &MsgPackWriter::Bool(bool value) {
+    out_.push_back(static_cast<char>(value ? BOOL_TRUE : BOOL_FALSE));
+    return *this;
+}
+
+} // namespace util
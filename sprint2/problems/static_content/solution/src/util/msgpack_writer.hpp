@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Writes MessagePack straight into a string, in the shortest encoding of every value. Maps and arrays start with
+// the number of their items; when it is not known up front, BeginMap leaves room for it and EndMap fills it in.
+// The caller is responsible for the structure: a map holds key and value pairs, the counts match the items.
+class MsgPackWriter {
+  public:
+    explicit MsgPackWriter(std::string &out) : out_(out) {}
+
+    MsgPackWriter &Map(std::uint32_t size);
+    MsgPackWriter &Array(std::uint32_t size);
+
+    // Map whose size is known once its items are written. Returns the position for EndMap.
+    std::size_t BeginMap();
+    MsgPackWriter &EndMap(std::size_t position, std::uint32_t size);
+
+    MsgPackWriter &String(std::string_view value);
+    MsgPackWriter &Uint(std::uint64_t value);
+    MsgPackWriter &Int(std::int64_t value);
+    // The shortest exact encoding: whole numbers as integers, then a 4-byte float if it holds the value exactly,
+    // an 8-byte one otherwise
+    MsgPackWriter &Number(double value);
+    MsgPackWriter &Bool(bool value);
+
+  private:
+    // Big-endian, as MessagePack stores numbers
+    template <typename T>
+    void Append(std::uint8_t type, T value);
+
+    std::string &out_;
+};
+
+} // namespace util
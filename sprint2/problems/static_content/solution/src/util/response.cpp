@@ -1,5 +1,7 @@
 #include "response.hpp"
 
+#include "etag.hpp"
+
 namespace util {
 
 Response Response::Text(http::status status, std::string_view body) {
@@ -32,9 +34,31 @@ Response Response::File(http::status status, std::string_view mime_type, std::st
     response.result(status);
     response.set(http::field::content_type, mime_type);
 
-    http::file_body::value_type file;
+    SendfileBody::value_type file;
+    file.open(filepath.data(), beast::file_mode::read, ec);
+    if (!ec) {
+        response.body() = std::move(file);
+        response.prepare_payload();
+    }
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
+Response Response::FilePart(http::status status, std::string_view mime_type, std::string_view filepath,
+                            std::uint64_t offset, std::uint64_t length, boost::system::error_code &ec) {
+    FileResponse response;
+    response.result(status);
+    response.set(http::field::content_type, mime_type);
+
+    SendfileBody::value_type file;
     file.open(filepath.data(), beast::file_mode::read, ec);
+    if (!ec && offset + length > file.size()) {
+        ec = make_error_code(boost::system::errc::invalid_seek);
+    }
     if (!ec) {
+        file.set_range(offset, length);
         response.body() = std::move(file);
         response.prepare_payload();
     }
@@ -44,6 +68,41 @@ Response Response::File(http::status status, std::string_view mime_type, std::st
     return result;
 }
 
+CachedBody CachedBody::Json(const json::value &value) {
+    auto body = std::make_shared<const std::string>(json::serialize(value));
+    auto etag = MakeETag(*body);
+    return CachedBody{std::move(body), std::move(etag)};
+}
+
+Response Response::Buffer(http::status status, std::string_view content_type, SharedBody::value_type body) {
+    SharedResponse response;
+    response.result(status);
+    response.set(http::field::content_type, content_type);
+    response.content_length(SharedBody::size(body));
+    response.body() = std::move(body);
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
+Response Response::Cached(http::status status, std::string_view content_type, const CachedBody &body) {
+    auto result = Buffer(status, content_type, body.body);
+    result.set("ETag", body.etag);
+    return result;
+}
+
+// 304 carries no body and no Content-Length, only the tag the client already has
+Response Response::NotModified(std::string_view etag) {
+    StringResponse response;
+    response.result(http::status::not_modified);
+    response.set(http::field::etag, etag);
+
+    Response result;
+    result = std::move(response);
+    return result;
+}
+
 Response &Response::operator=(StringResponse &&response_) {
     response = std::move(response_);
     return *this;
@@ -52,6 +111,10 @@ Response &Response::operator=(FileResponse &&response_) {
     response = std::move(response_);
     return *this;
 }
+Response &Response::operator=(SharedResponse &&response_) {
+    response = std::move(response_);
+    return *this;
+}
 
 int Response::code() const {
     int code;
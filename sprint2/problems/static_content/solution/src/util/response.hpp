@@ -1,13 +1,17 @@
 #pragma once
 
-#include <boost/asio/strand.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <variant>
 
+#include "sendfile_body.hpp"
+#include "shared_body.hpp"
+
 namespace util {
 
 namespace beast = boost::beast;
@@ -15,21 +19,35 @@ namespace http = beast::http;
 namespace json = boost::json;
 
 using StringResponse = http::response<http::string_body>;
-using FileResponse = http::response<http::file_body>;
+using FileResponse = http::response<SendfileBody>;
+using SharedResponse = http::response<SharedBody>;
+
+// Body serialized once, together with its entity tag, and shared by every response that sends it
+struct CachedBody {
+    static CachedBody Json(const json::value &value);
+
+    SharedBody::value_type body;
+    std::string etag;
+};
 
 class Response : public std::enable_shared_from_this<Response> {
   public:
-    using Strand = beast::net::strand<beast::net::io_context::executor_type>;
-
     Response() {}
 
     static Response Text(http::status status, std::string_view body);
     static Response Json(http::status status, const json::value &value);
     static Response File(http::status status, std::string_view mime_type, std::string_view filepath,
                          boost::system::error_code &ec);
+    // Only length bytes of the file starting at offset, for 206 Partial Content
+    static Response FilePart(http::status status, std::string_view mime_type, std::string_view filepath,
+                             std::uint64_t offset, std::uint64_t length, boost::system::error_code &ec);
+    static Response Buffer(http::status status, std::string_view content_type, SharedBody::value_type body);
+    static Response Cached(http::status status, std::string_view content_type, const CachedBody &body);
+    static Response NotModified(std::string_view etag);
 
     Response &operator=(StringResponse &&response_);
     Response &operator=(FileResponse &&response_);
+    Response &operator=(SharedResponse &&response_);
 
     int code() const;
     std::string_view content_type() const;
@@ -44,14 +62,6 @@ class Response : public std::enable_shared_from_this<Response> {
         std::visit([send_fn = std::move(send_fn)](auto &&arg) { send_fn(std::move(arg)); }, response);
     }
 
-    template <typename Send>
-    void send(Send &&send_fn, Strand api_strand) {
-        boost::beast::net::dispatch(
-            api_strand, [send_fn = std::move(send_fn), response = std::move(this->response)]() mutable {
-                std::visit([send_fn = std::move(send_fn)](auto &&arg) { send_fn(std::move(arg)); }, response);
-            });
-    }
-
   private:
     template <typename Body>
     static void FinalizeResponse(http::response<Body> &response, unsigned http_version, bool keep_alive) {
@@ -59,7 +69,7 @@ class Response : public std::enable_shared_from_this<Response> {
         response.keep_alive(keep_alive);
     }
 
-    std::variant<StringResponse, FileResponse> response;
+    std::variant<StringResponse, FileResponse, SharedResponse> response;
 };
 
 } // namespace util
\ No newline at end of file
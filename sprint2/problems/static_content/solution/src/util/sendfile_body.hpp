@@ -0,0 +1,84 @@
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core/file.hpp>
+#include <boost/beast/http/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace util {
+
+// Body of a response sending a file, or a byte range of it. HTTP sessions send it with sendfile(2) where it is
+// available, straight from the page cache. Serialized the regular way it reads the file through a buffer.
+struct SendfileBody {
+    class value_type {
+      public:
+        bool is_open() const { return file_.is_open(); }
+
+        // Open the file and send it whole
+        void open(const char *path, boost::beast::file_mode mode, boost::system::error_code &ec) {
+            file_.open(path, mode, ec);
+            if (!ec) {
+                offset_ = 0;
+                size_ = file_.size(ec);
+            }
+        }
+
+        // Send only size bytes starting at offset, which must lie within the file
+        void set_range(std::uint64_t offset, std::uint64_t size) {
+            offset_ = offset;
+            size_ = size;
+        }
+
+        boost::beast::file &file() { return file_; }
+        std::uint64_t offset() const { return offset_; }
+        std::uint64_t size() const { return size_; }
+
+      private:
+        boost::beast::file file_;
+        std::uint64_t offset_ = 0;
+        std::uint64_t size_ = 0;
+    };
+
+    static std::uint64_t size(const value_type &body) { return body.size(); }
+
+    class writer {
+      public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, typename Fields>
+        writer(boost::beast::http::header<isRequest, Fields> &, value_type &body)
+            : body_(body), remain_(body.size()) {}
+
+        void init(boost::system::error_code &ec) { body_.file().seek(body_.offset(), ec); }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::system::error_code &ec) {
+            const auto amount = static_cast<std::size_t>(std::min<std::uint64_t>(remain_, sizeof(buffer_)));
+            if (amount == 0) {
+                ec = {};
+                return boost::none;
+            }
+            const auto read = body_.file().read(buffer_, amount, ec);
+            if (ec) {
+                return boost::none;
+            }
+            if (read == 0) {
+                ec = boost::beast::http::error::short_read;
+                return boost::none;
+            }
+            remain_ -= read;
+            return {{const_buffers_type{buffer_, read}, remain_ > 0}};
+        }
+
+      private:
+        value_type &body_;
+        std::uint64_t remain_;
+        char buffer_[4096];
+    };
+};
+
+} // namespace util
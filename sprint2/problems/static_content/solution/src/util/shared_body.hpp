@@ -0,0 +1,47 @@
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace util {
+
+// Buffer a response body is serialized into. A connection keeps one and lends it to every request it reads,
+// so its capacity is reused once the previous response has been written.
+using BodyBuffer = std::shared_ptr<std::string>;
+
+// Body of an HTTP response that borrows an immutable, already serialized buffer. Copying the message copies only
+// the pointer, so one buffer built at startup can be sent by any number of connections at once.
+struct SharedBody {
+    using value_type = std::shared_ptr<const std::string>;
+
+    static std::uint64_t size(const value_type &body) { return body ? body->size() : 0; }
+
+    class writer {
+      public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, typename Fields>
+        writer(const boost::beast::http::header<isRequest, Fields> &, const value_type &body) : body_(body) {}
+
+        void init(boost::system::error_code &ec) { ec = {}; }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::system::error_code &ec) {
+            ec = {};
+            if (!body_ || body_->empty()) {
+                return boost::none;
+            }
+            return {{const_buffers_type{body_->data(), body_->size()}, false}};
+        }
+
+      private:
+        const value_type &body_;
+    };
+};
+
+} // namespace util
@@ -1,39 +1,137 @@
 #include "ticker.hpp"
 
+#include <algorithm>
+#include <cassert>
+
 namespace util {
 
 namespace net = boost::beast::net;
 
-Ticker::Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
-    : strand_{strand}, period_{period}, handler_{std::move(handler)} {}
+using namespace std::literals;
+
+Ticker::Ticker(Strand strand, std::chrono::milliseconds period, Handler handler, TickerOptions options)
+    : strand_{strand}, period_{period}, handler_{std::move(handler)}, options_{options},
+      overruns_(Metrics().GetCounter("game_ticker_overruns_total"sv,
+                                     "Ticker wake-ups late by a whole period or more"sv)),
+      catch_up_ticks_(Metrics().GetCounter("game_ticker_catch_up_ticks_total"sv,
+                                           "Extra ticks run to catch up with the real time"sv)),
+      dropped_ticks_(Metrics().GetCounter("game_ticker_dropped_ticks_total"sv,
+                                          "Ticks skipped when catching up took more than its budget"sv)),
+      lateness_(Metrics().GetHistogram("game_ticker_lateness_seconds"sv, "Delay of ticker wake-ups"sv)) {}
 
 void Ticker::Start() {
     net::dispatch(strand_, [self = shared_from_this()] {
         self->last_tick_ = Clock::now();
+        self->deadline_ = self->last_tick_;
         self->ScheduleTick();
     });
 }
 
 void Ticker::ScheduleTick() {
     assert(strand_.running_in_this_thread());
-    timer_.expires_after(period_);
+    deadline_ += period_;
+    timer_.expires_at(deadline_);
     timer_.async_wait([self = shared_from_this()](boost::beast::error_code ec) { self->OnTick(ec); });
 }
 
+void Ticker::Run(std::chrono::milliseconds delta) {
+    try {
+        handler_(delta);
+    } catch (...) {
+    }
+}
+
 void Ticker::OnTick(boost::beast::error_code ec) {
     using namespace std::chrono;
     assert(strand_.running_in_this_thread());
 
-    if (!ec) {
-        auto this_tick = Clock::now();
-        auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-        last_tick_ = this_tick;
-        try {
-            handler_(delta);
-        } catch (...) {
+    if (ec) {
+        return;
+    }
+    auto now = Clock::now();
+    lateness_.Observe(now - deadline_);
+    if (now - deadline_ >= period_) {
+        overruns_.Inc();
+    }
+
+    if (options_.mode == TickMode::VARIABLE) {
+        auto delta = duration_cast<milliseconds>(now - last_tick_);
+        // The part of a millisecond left over goes to the next tick
+        last_tick_ += delta;
+        Run(delta);
+    } else {
+        unsigned ticks = 0;
+        for (; now - last_tick_ >= period_ && ticks < options_.max_catch_up; ++ticks) {
+            Run(period_);
+            last_tick_ += period_;
+        }
+        if (ticks > 1) {
+            catch_up_ticks_.Inc(ticks - 1);
+        }
+        if (auto behind = (now - last_tick_) / period_; behind > 0) {
+            dropped_ticks_.Inc(behind);
+            last_tick_ += behind * period_;
+        }
+    }
+
+    // Deadlines that have passed while the handler ran are skipped
+    if (auto missed = (Clock::now() - deadline_) / period_; missed > 0) {
+        deadline_ += missed * period_;
+    }
+    ScheduleTick();
+}
+
+PendingTicks::PendingTicks(std::chrono::milliseconds period, TickerOptions options)
+    : period_{period}, options_{options},
+      dropped_ticks_(Metrics().GetCounter("game_ticker_dropped_ticks_total"sv,
+                                          "Ticks skipped when catching up took more than its budget"sv)) {}
+
+bool PendingTicks::Add(std::chrono::milliseconds delta) noexcept {
+    return pending_.fetch_add(delta.count(), std::memory_order_acq_rel) == 0;
+}
+
+PendingTicks::Ticks PendingTicks::Take() noexcept {
+    const std::chrono::milliseconds pending{pending_.exchange(0, std::memory_order_acq_rel)};
+    if (pending.count() == 0) {
+        return {};
+    }
+    if (options_.mode == TickMode::VARIABLE) {
+        return {1, pending};
+    }
+    // Fixed ticks are added in whole periods
+    const auto ticks = static_cast<unsigned>(pending / period_);
+    const auto run = std::min(ticks, options_.max_catch_up);
+    if (ticks > run) {
+        dropped_ticks_.Inc(ticks - run);
+    }
+    return {run, period_};
+}
+
+void TickLimiter::Run(Start start) {
+    {
+        std::lock_guard lock{mutex_};
+        if (running_ == max_running_) {
+            waiting_.push_back(std::move(start));
+            return;
+        }
+        ++running_;
+    }
+    start();
+}
+
+void TickLimiter::Done() {
+    Start next;
+    {
+        std::lock_guard lock{mutex_};
+        if (waiting_.empty()) {
+            --running_;
+            return;
         }
-        ScheduleTick();
+        // The slot goes to the next waiting tick as it is
+        next = std::move(waiting_.front());
+        waiting_.pop_front();
     }
+    next();
 }
 
-} // namespace util
\ No newline at end of file
+} // namespace util
@@ -1,31 +1,120 @@
+#pragma once
+
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/http.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+
+#include "metrics.hpp"
 
 namespace util {
 
+// How the time between wake-ups of the ticker is turned into ticks
+enum class TickMode {
+    // One tick of the real time since the previous one
+    VARIABLE,
+    // Ticks of exactly one period. Real time is advanced in whole periods, so a late wake-up runs several short
+    // ticks instead of one long one.
+    FIXED,
+};
+
+struct TickerOptions {
+    TickMode mode = TickMode::VARIABLE;
+    // Most ticks run at one wake-up in the fixed mode. The time beyond them is dropped: after a long pause the game
+    // falls behind the real time instead of stalling the strand with ticks.
+    unsigned max_catch_up = 5;
+};
+
 class Ticker : public std::enable_shared_from_this<Ticker> {
   public:
     using Strand = boost::beast::net::strand<boost::beast::net::io_context::executor_type>;
     using Handler = std::function<void(std::chrono::milliseconds delta)>;
 
     // Функция handler будет вызываться внутри strand с интервалом period
-    Ticker(Strand strand, std::chrono::milliseconds period, Handler handler);
+    Ticker(Strand strand, std::chrono::milliseconds period, Handler handler, TickerOptions options = {});
     void Start();
 
   private:
+    using Clock = std::chrono::steady_clock;
+
     void ScheduleTick();
     void OnTick(boost::beast::error_code ec);
-
-    using Clock = std::chrono::steady_clock;
+    void Run(std::chrono::milliseconds delta);
 
     Strand strand_;
     std::chrono::milliseconds period_;
     boost::beast::net::steady_timer timer_{strand_};
     Handler handler_;
-    std::chrono::steady_clock::time_point last_tick_;
+    const TickerOptions options_;
+    // Wake-ups are planned on the grid of periods from the start, so the time the handler takes does not add up
+    Clock::time_point deadline_;
+    // The real time simulated so far
+    Clock::time_point last_tick_;
+
+    Counter &overruns_;
+    Counter &catch_up_ticks_;
+    Counter &dropped_ticks_;
+    Histogram &lateness_;
+};
+
+// Ticks the handler of a Ticker passes on to another strand, that of a game session. A stall of that strand, such as a
+// slow log flush, is not seen by the ticker, so its ticks are added up here instead of being queued one post each:
+// once the strand is free it runs them as the ticker would after a late wake-up. In the fixed mode that is at most
+// max_catch_up ticks of one period, the rest is dropped and counted; in the variable mode one tick of all the time.
+class PendingTicks {
+  public:
+    struct Ticks {
+        unsigned count = 0;
+        std::chrono::milliseconds delta{0};
+    };
+
+    PendingTicks(std::chrono::milliseconds period, TickerOptions options);
+
+    PendingTicks(const PendingTicks &) = delete;
+    PendingTicks &operator=(const PendingTicks &) = delete;
+
+    // Thread-safe. True if nothing was pending, then the caller posts a task to the strand that calls Take.
+    bool Add(std::chrono::milliseconds delta) noexcept;
+
+    // The ticks to run now, called on the strand
+    Ticks Take() noexcept;
+
+  private:
+    const std::chrono::milliseconds period_;
+    const TickerOptions options_;
+    std::atomic<std::chrono::milliseconds::rep> pending_{0};
+
+    Counter &dropped_ticks_;
+};
+
+// Caps how many ticks of game sessions run at once. Each session ticks on its own strand, so without a cap a tick
+// takes as many threads of the io_context as there are sessions. A tick over the cap waits until a running one is
+// done, waiting ticks start in the order they came. Thread-safe.
+class TickLimiter {
+  public:
+    using Start = std::function<void()>;
+
+    explicit TickLimiter(unsigned max_running) : max_running_{std::max(1u, max_running)} {}
+
+    TickLimiter(const TickLimiter &) = delete;
+    TickLimiter &operator=(const TickLimiter &) = delete;
+
+    // Calls start now or once a running tick is done. The tick started must call Done when it has run.
+    void Run(Start start);
+    void Done();
+
+  private:
+    const unsigned max_running_;
+    std::mutex mutex_;
+    unsigned running_ = 0;
+    std::deque<Start> waiting_;
 };
 
-} // namespace util
\ No newline at end of file
+} // namespace util
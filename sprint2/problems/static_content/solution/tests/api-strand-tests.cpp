@@ -0,0 +1,123 @@
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "test_api.hpp"
+#include "test_maps.hpp"
+
+using namespace std::literals;
+
+namespace net = boost::asio;
+
+using test::Call;
+using test::MakeRequest;
+
+// Meant to be run under ThreadSanitizer as well, see GAME_SERVER_TSAN in CMakeLists.txt
+SCENARIO("API endpoints under concurrent load") {
+    GIVEN("a server with two maps running on several threads") {
+        model::Game game{{test::MakeMap("map1"s, test::Corner(), 2.0), test::MakeMap("map2"s, test::Corner(), 2.0)}};
+        game.SetRandomizeSpawnPoint(true);
+
+        net::io_context ioc;
+        auto work = net::make_work_guard(ioc);
+        api_handler::Strands strands{ioc, game.GetMaps()};
+        api_handler::APIHandler api{game, strands};
+        // Outlives the io_context threads, ticks posted by the ticker may still be running when a WHEN block ends
+        std::atomic<int> ticks{0};
+
+        std::vector<std::jthread> io_threads;
+        for (int i = 0; i < 4; ++i) {
+            io_threads.emplace_back([&ioc] { ioc.run(); });
+        }
+
+        WHEN("clients join, move and poll while the game ticks") {
+            constexpr int clients = 8;
+            constexpr int players_per_client = 20;
+            constexpr int rounds = 20;
+            const char *moves[] = {"L", "R", "U", "D", ""};
+
+            // Same as the server ticker: the session list is read on the global strand, sessions tick on their own
+            std::atomic<bool> ticking{true};
+            std::jthread ticker{[&] {
+                while (ticking) {
+                    std::promise<void> posted;
+                    net::post(strands.Global(), [&] {
+                        for (auto &session : game.GetSessions()) {
+                            net::post(strands.Session(session.GetMap().GetId()), [&session, &ticks] {
+                                session.Tick(10);
+                                ++ticks;
+                            });
+                        }
+                        posted.set_value();
+                    });
+                    posted.get_future().wait();
+                    std::this_thread::yield();
+                }
+            }};
+
+            std::atomic<int> failures{0};
+            std::vector<std::jthread> client_threads;
+            for (int client = 0; client < clients; ++client) {
+                client_threads.emplace_back([&, client] {
+                    std::vector<std::string> tokens;
+                    for (int i = 0; i < players_per_client; ++i) {
+                        auto map = i % 2 ? "map1"s : "map2"s;
+                        auto body = R"({"userName":"dog)"s + std::to_string(client) + "_" + std::to_string(i) +
+                                    R"(","mapId":")" + map + R"("})";
+                        auto reply = Call(api, MakeRequest(http::verb::post, "/api/v1/game/join"sv, {}, body));
+                        auto token = reply.body.find(R"("authToken":")");
+                        if (reply.code != 200 || token == std::string::npos) {
+                            ++failures;
+                            continue;
+                        }
+                        tokens.push_back(reply.body.substr(token + 13, 32));
+                    }
+
+                    for (int round = 0; round < rounds && !tokens.empty(); ++round) {
+                        for (std::size_t i = 0; i < tokens.size(); ++i) {
+                            auto move = R"({"move":")"s + moves[(round + i) % std::size(moves)] + R"("})";
+                            auto action = Call(api, MakeRequest(http::verb::post, "/api/v1/game/player/action"sv,
+                                                                tokens[i], move));
+                            auto state = Call(api, MakeRequest(http::verb::get, "/api/v1/game/state"sv, tokens[i]));
+                            failures += action.code != 200;
+                            failures += state.code != 200;
+                        }
+                        auto players = Call(api, MakeRequest(http::verb::get, "/api/v1/game/players"sv, tokens[0]));
+                        failures += players.code != 200;
+                    }
+                });
+            }
+            client_threads.clear();
+            ticking = false;
+            ticker.join();
+
+            THEN("every request succeeds and every player lands in its session") {
+                CHECK(failures == 0);
+                CHECK(ticks > 0);
+
+                // Every join has responded, and ticks never touch the player lists
+                std::size_t players = 0;
+                for (auto &session : game.GetSessions()) {
+                    players += session.GetPlayers().size();
+                }
+                CHECK(players == clients * players_per_client);
+            }
+
+            THEN("an unknown token is rejected") {
+                auto reply = Call(api, MakeRequest(http::verb::get, "/api/v1/game/state"sv, "0123456789abcdef"sv));
+                CHECK(reply.code == 401);
+            }
+        }
+
+        work.reset();
+        ioc.stop();
+    }
+}
@@ -0,0 +1,123 @@
+#include <boost/json.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/util/async_log.hpp"
+
+using namespace std::literals;
+
+using util::AsyncLog;
+using util::AsyncLogOptions;
+using util::LogOverflow;
+using util::LogRecord;
+
+namespace {
+
+std::vector<std::string> Lines(const std::string &text) {
+    std::vector<std::string> lines;
+    std::istringstream in{text};
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+LogRecord Request(std::string_view uri) { return {LogRecord::Kind::REQUEST, 0, 0, {"127.0.0.1"sv, uri, "GET"sv}}; }
+
+} // namespace
+
+SCENARIO("Asynchronous log") {
+    GIVEN("a record") {
+        WHEN("it is formatted") {
+            std::string line;
+            AsyncLog::Format(LogRecord{LogRecord::Kind::RESPONSE, 12, 404, {"text/plain"sv}}, line);
+            auto value = boost::json::parse(line);
+
+            THEN("it looks like a line of the synchronous log") {
+                const auto &object = value.as_object();
+                CHECK(object.contains("timestamp"));
+                CHECK(object.at("message").as_string() == "response sent");
+                const auto &data = object.at("data").as_object();
+                CHECK(data.at("response_time").as_int64() == 12);
+                CHECK(data.at("code").as_int64() == 404);
+                CHECK(data.at("content_type").as_string() == "text/plain");
+            }
+        }
+
+        WHEN("its strings do not fit") {
+            const std::string uri(1000, 'a');
+            LogRecord record = Request(uri);
+
+            THEN("they are cut") {
+                CHECK(record.String(0) == "127.0.0.1");
+                CHECK(record.String(1).size() == LogRecord::TEXT_SIZE - 9);
+                CHECK(record.String(2).empty());
+            }
+        }
+    }
+
+    GIVEN("a log that makes threads wait when it falls behind") {
+        std::ostringstream out;
+        {
+            AsyncLog log{out, AsyncLogOptions{.queue_size = 8, .overflow = LogOverflow::BLOCK}};
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < 4; ++i) {
+                threads.emplace_back([&log, i] {
+                    for (int j = 0; j < 500; ++j) {
+                        log.Push(Request("/"s + std::to_string(i) + '/' + std::to_string(j)));
+                    }
+                });
+            }
+        }
+
+        THEN("every record is written by the time it is destroyed, in order within a thread") {
+            auto lines = Lines(out.str());
+            REQUIRE(lines.size() == 2000);
+            int last = -1;
+            for (const auto &line : lines) {
+                auto value = boost::json::parse(line);
+                std::string_view uri = value.as_object().at("data").as_object().at("uri").as_string();
+                if (uri.starts_with("/0/")) {
+                    int index = std::stoi(std::string{uri.substr(3)});
+                    CHECK(index == last + 1);
+                    last = index;
+                }
+            }
+            CHECK(last == 499);
+        }
+    }
+
+    GIVEN("a log that drops records when it falls behind") {
+        std::ostringstream out;
+        std::uint64_t dropped = 0;
+        {
+            AsyncLog log{out, AsyncLogOptions{.queue_size = 4, .overflow = LogOverflow::DROP}};
+            for (int i = 0; i < 10000; ++i) {
+                log.Push(Request("/"sv));
+            }
+            dropped = log.Dropped();
+        }
+
+        THEN("the lost records are counted in the log") {
+            auto lines = Lines(out.str());
+            std::uint64_t written = 0;
+            std::uint64_t reported = 0;
+            for (const auto &line : lines) {
+                auto value = boost::json::parse(line);
+                const auto &object = value.as_object();
+                if (object.at("message").as_string() == "log records dropped") {
+                    reported += object.at("data").as_object().at("count").to_number<std::uint64_t>();
+                } else {
+                    ++written;
+                }
+            }
+            CHECK(written + dropped == 10000);
+            CHECK(reported == dropped);
+        }
+    }
+}
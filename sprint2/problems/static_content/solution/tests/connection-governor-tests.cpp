@@ -0,0 +1,67 @@
+#include <boost/asio/ip/address.hpp>
+
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/connection_governor.hpp"
+
+using http_server::ConnectionGovernor;
+using http_server::ConnectionLimits;
+
+namespace {
+
+const auto first_client = boost::asio::ip::make_address("10.0.0.1");
+const auto second_client = boost::asio::ip::make_address("10.0.0.2");
+
+} // namespace
+
+SCENARIO("Connection governor") {
+    GIVEN("a governor for 3 connections, 2 per address") {
+        auto governor =
+            std::make_shared<ConnectionGovernor>(ConnectionLimits{.max_connections = 3, .max_connections_per_ip = 2});
+
+        WHEN("one address opens connections") {
+            auto first = governor->Admit(first_client);
+            auto second = governor->Admit(first_client);
+
+            THEN("it gets no more than its share") {
+                CHECK(first);
+                CHECK(second);
+                CHECK(!governor->Admit(first_client));
+                CHECK(governor->Connections() == 2);
+            }
+
+            THEN("a closed connection makes room for another one") {
+                first = {};
+                CHECK(governor->Admit(first_client));
+            }
+        }
+
+        WHEN("the server is full") {
+            std::vector<ConnectionGovernor::Ticket> tickets;
+            tickets.push_back(governor->Admit(first_client));
+            tickets.push_back(governor->Admit(second_client));
+            tickets.push_back(governor->Admit(second_client));
+            REQUIRE(governor->Connections() == 3);
+
+            bool resumed = false;
+            governor->WhenAvailable([&resumed] { resumed = true; });
+
+            THEN("connections are refused and accepting waits until one of them ends") {
+                CHECK(!governor->Admit(first_client));
+                CHECK(!resumed);
+
+                tickets.pop_back();
+                CHECK(resumed);
+                CHECK(governor->Connections() == 2);
+            }
+        }
+
+        THEN("accepting goes on right away while there is room") {
+            bool resumed = false;
+            governor->WhenAvailable([&resumed] { resumed = true; });
+            CHECK(resumed);
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model/model.hpp"
+#include "test_maps.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+// Counts heap allocations made while armed, the rest of the test binary is not affected
+std::atomic<bool> count_allocations{false};
+std::atomic<std::size_t> allocations{0};
+
+class AllocationCounter {
+  public:
+    AllocationCounter() {
+        allocations = 0;
+        count_allocations = true;
+    }
+    ~AllocationCounter() { count_allocations = false; }
+
+    std::size_t Count() const { return allocations; }
+};
+
+// A street of three roads joined end to end, one of them drawn backwards, and a road past a gap after it
+model::Map MakeStreetMap() {
+    return test::MakeMap("map2"s,
+                         {{model::Orientation::HORIZONTAL, {0, 0}, 10},
+                          {model::Orientation::HORIZONTAL, {40, 0}, 25},
+                          {model::Orientation::HORIZONTAL, {10, 0}, 25},
+                          {model::Orientation::HORIZONTAL, {45, 0}, 60}},
+                         1.0);
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (count_allocations) {
+        ++allocations;
+    }
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+SCENARIO("Game tick") {
+    GIVEN("a game with a single session") {
+        model::Game game{{test::MakeMap("map1"s, test::Square(), 1.0)}};
+        game.SetRandomizeSpawnPoint(true);
+        const auto &map = game.GetMaps().front();
+        auto &session = game.AddSession(map);
+
+        WHEN("a dog runs past the end of its road") {
+            game.SetRandomizeSpawnPoint(false);
+            auto [player, _] = game.AddPlayer("dog"s, session);
+            player->GetDog()->SetSpeed({1.0, 0.0});
+            game.Tick(100'000);
+
+            THEN("it stops at the road edge") {
+                CHECK(player->GetDog()->GetPosition() == std::pair{40.4, 0.0});
+                CHECK(player->GetDog()->GetSpeed() == std::pair{0.0, 0.0});
+            }
+        }
+
+        WHEN("a dog tries to leave the road sideways") {
+            game.SetRandomizeSpawnPoint(false);
+            auto [player, _] = game.AddPlayer("dog"s, session);
+            player->GetDog()->SetPosition({20.0, 0.0});
+            player->GetDog()->SetSpeed({0.0, -1.0});
+            game.Tick(1'000);
+
+            THEN("it is bounded by the road width") {
+                CHECK(player->GetDog()->GetPosition() == std::pair{20.0, -0.4});
+                CHECK(player->GetDog()->GetSpeed() == std::pair{0.0, 0.0});
+            }
+        }
+
+        WHEN("5000 dogs are moving") {
+            for (int i = 0; i < 5'000; ++i) {
+                auto [player, _] = game.AddPlayer("dog"s + std::to_string(i), session);
+                auto [x, y] = player->GetDog()->GetPosition();
+                bool on_horizontal = y == 0 || y == 30;
+                double speed = i % 2 ? 1.0 : -1.0;
+                player->GetDog()->SetSpeed(on_horizontal ? std::pair{speed, 0.0} : std::pair{0.0, speed});
+            }
+
+            THEN("a tick performs no heap allocations") {
+                AllocationCounter counter;
+                game.Tick(50);
+                game.Tick(50);
+                CHECK(counter.Count() == 0);
+            }
+        }
+    }
+    GIVEN("a game on a street of several roads") {
+        model::Game game{{MakeStreetMap()}};
+        auto &session = game.AddSession(game.GetMaps().front());
+        auto [player, _] = game.AddPlayer("dog"s, session);
+
+        WHEN("a dog runs along the street in one tick") {
+            player->GetDog()->SetSpeed({1.0, 0.0});
+            game.Tick(100'000);
+
+            THEN("it passes the joints of the roads and stops where the street ends") {
+                CHECK(player->GetDog()->GetPosition() == std::pair{40.4, 0.0});
+                CHECK(player->GetDog()->GetSpeed() == std::pair{0.0, 0.0});
+            }
+        }
+
+        WHEN("a dog runs back along the street") {
+            player->GetDog()->SetPosition({30.0, 0.0});
+            player->GetDog()->SetSpeed({-1.0, 0.0});
+            game.Tick(100'000);
+
+            THEN("it stops at the other end") {
+                CHECK(player->GetDog()->GetPosition() == std::pair{-0.4, 0.0});
+            }
+        }
+    }
+
+    GIVEN("the segments of a street") {
+        const auto map = MakeStreetMap();
+        const auto &segments = map.GetRoadSegments();
+
+        THEN("the joined roads share one segment with the road width") {
+            REQUIRE(segments.GetSegments().size() == 2);
+            const auto &street = segments.OfRoad(0);
+            CHECK(&segments.OfRoad(1) == &street);
+            CHECK(&segments.OfRoad(2) == &street);
+            CHECK(street.min_x == -0.4);
+            CHECK(street.max_x == 40.4);
+            CHECK(street.min_y == -0.4);
+            CHECK(street.max_y == 0.4);
+        }
+        THEN("a road past a gap has its own segment") {
+            CHECK(&segments.OfRoad(3) != &segments.OfRoad(0));
+            CHECK(segments.OfRoad(3).min_x == 44.6);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/http_server.hpp"
+
+using namespace std::literals;
+
+namespace fs = std::filesystem;
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+using tcp = net::ip::tcp;
+
+namespace {
+
+constexpr std::size_t BODY_SIZE = 8 * 1024 * 1024;
+
+// Answers /string with a body in memory and /file with the file, both BODY_SIZE bytes long
+struct LargeResponses {
+    fs::path file;
+
+    template <typename Send>
+    void operator()(std::string, const http::request<http::string_body> &request, util::BodyBuffer, Send &&send) {
+        if (request.target() == "/file"sv) {
+            http::response<util::SendfileBody> response{http::status::ok, request.version()};
+            boost::system::error_code ec;
+            response.body().open(file.c_str(), boost::beast::file_mode::scan, ec);
+            response.prepare_payload();
+            return send(std::move(response));
+        }
+        http::response<http::string_body> response{http::status::ok, request.version()};
+        response.body().assign(BODY_SIZE, 'x');
+        response.prepare_payload();
+        send(std::move(response));
+    }
+};
+
+// A server session on one end of a loopback connection and a client with a small receive buffer on the other one
+class Connection {
+  public:
+    Connection(http_server::ConnectionLimits limits, LargeResponses handler)
+        : governor_(std::make_shared<http_server::ConnectionGovernor>(limits)) {
+        tcp::acceptor acceptor{ioc_, {net::ip::make_address("127.0.0.1"), 0}};
+        client_.open(tcp::v4());
+        client_.set_option(net::socket_base::receive_buffer_size(16 * 1024));
+        client_.connect(acceptor.local_endpoint());
+        auto socket = acceptor.accept(net::make_strand(ioc_));
+        auto ticket = governor_->Admit(socket.remote_endpoint().address());
+        std::make_shared<http_server::Session<LargeResponses>>(std::move(socket), std::move(ticket),
+                                                               governor_->Limits(), std::move(handler))
+            ->Run();
+        server_ = std::thread{[this] { ioc_.run(); }};
+    }
+
+    ~Connection() {
+        boost::system::error_code ec;
+        client_.close(ec);
+        server_.join();
+    }
+
+    // Sends a request and reads the response slowly, false if the connection breaks before its end
+    bool Get(std::string_view target) {
+        net::write(client_, net::buffer("GET "s + std::string{target} + " HTTP/1.1\r\nHost: test\r\n\r\n"s));
+        std::string received;
+        std::size_t expected = std::string::npos;
+        char chunk[64 * 1024];
+        while (received.size() < expected) {
+            boost::system::error_code ec;
+            auto read = client_.read_some(net::buffer(chunk), ec);
+            if (ec) {
+                return false;
+            }
+            received.append(chunk, read);
+            if (auto header_end = received.find("\r\n\r\n"sv); header_end != std::string::npos) {
+                expected = header_end + 4 + BODY_SIZE;
+            }
+            std::this_thread::sleep_for(2ms);
+        }
+        return received.size() == expected;
+    }
+
+    // True if the server closes the connection while the client sends nothing
+    bool ClosedByServer() {
+        char byte;
+        boost::system::error_code ec;
+        client_.read_some(net::buffer(&byte, 1), ec);
+        return ec == net::error::eof;
+    }
+
+  private:
+    net::io_context ioc_;
+    std::shared_ptr<http_server::ConnectionGovernor> governor_;
+    tcp::socket client_{ioc_};
+    std::thread server_;
+};
+
+} // namespace
+
+SCENARIO("HTTP session timeouts") {
+    GIVEN("a session with a header timeout shorter than the time to receive a response") {
+        const http_server::ConnectionLimits limits{.header_timeout = 50ms};
+        const auto file = fs::temp_directory_path() / ("http-server-tests-"s + std::to_string(::getpid()));
+        std::ofstream{file, std::ios::binary} << std::string(BODY_SIZE, 'x');
+
+        // The header of the next request is waited for while the response is being written
+        auto check_response = [&](std::string_view target) {
+            Connection connection{limits, LargeResponses{file}};
+            const auto start = std::chrono::steady_clock::now();
+            CHECK(connection.Get(target));
+            CHECK(std::chrono::steady_clock::now() - start > limits.header_timeout);
+            // Once the response is written the idle connection times out
+            CHECK(connection.ClosedByServer());
+        };
+
+        WHEN("a client reads a large response from memory slowly") {
+            check_response("/string"sv);
+        }
+        WHEN("a client reads a large file slowly") {
+            check_response("/file"sv);
+        }
+        fs::remove(file);
+    }
+}
@@ -0,0 +1,115 @@
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model/model.hpp"
+#include "../src/util/json_writer.hpp"
+#include "test_maps.hpp"
+
+using namespace std::literals;
+
+namespace json = boost::json;
+
+namespace {
+
+template <typename Response>
+std::string Write(const Response &response) {
+    std::string out;
+    util::JsonWriter writer{out};
+    model::api::responses::WriteJson(writer, response);
+    return out;
+}
+
+// Equal as JSON documents: integral and fractional numbers compare by value, "20" is the same as 2E1
+bool SameJson(const json::value &a, const json::value &b) {
+    if (a.is_number() && b.is_number()) {
+        return a.to_number<double>() == b.to_number<double>();
+    }
+    if (a.is_object() && b.is_object()) {
+        const auto &lhs = a.as_object(), &rhs = b.as_object();
+        return lhs.size() == rhs.size() && std::all_of(lhs.begin(), lhs.end(), [&](const auto &item) {
+                   return rhs.contains(item.key()) && SameJson(item.value(), rhs.at(item.key()));
+               });
+    }
+    if (a.is_array() && b.is_array()) {
+        const auto &lhs = a.as_array(), &rhs = b.as_array();
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), SameJson);
+    }
+    return a == b;
+}
+
+} // namespace
+
+SCENARIO("Streaming JSON writer") {
+    GIVEN("a writer over a string") {
+        std::string out;
+        util::JsonWriter writer{out};
+
+        WHEN("nested values are written") {
+            writer.BeginObject().Key("a").BeginArray().Number(0.5).Number(std::uint64_t{3}).EndArray();
+            writer.Key(std::uint64_t{7}).BeginObject().EndObject().Key("s").String("x").EndObject();
+
+            THEN("commas and colons are placed between them") {
+                CHECK(out == R"({"a":[0.5,3],"7":{},"s":"x"})");
+            }
+        }
+
+        WHEN("a string needs escaping") {
+            writer.String("q\"b\\n\nt\t\x01");
+
+            THEN("it stays a valid JSON string") {
+                CHECK(out == R"("q\"b\\n\nt\t\u0001")");
+                CHECK(json::parse(out).as_string() == "q\"b\\n\nt\t\x01");
+            }
+        }
+    }
+
+    GIVEN("a session with moving players") {
+        model::Game game{{test::MakeMap("map1"s, test::Corner(), 1.5)}};
+        auto &session = game.AddSession(game.GetMaps().front());
+        for (int i = 0; i < 10; ++i) {
+            auto [player, _] = game.AddPlayer("dog \"" + std::to_string(i) + "\"", session);
+            player->GetDog()->SetSpeed({i % 2 ? 1.5 : 0.0, 0.0});
+        }
+        session.Tick(333);
+
+        THEN("state and players are the same JSON as the values they used to be built from") {
+            const model::api::responses::GetStateResponse state{session.GetPlayers()};
+            const model::api::responses::GetPlayersResponse players{session.GetPlayers()};
+            CHECK(SameJson(json::parse(Write(state)), json::value_from(state)));
+            CHECK(SameJson(json::parse(Write(players)), json::value_from(players)));
+        }
+
+        WHEN("the game ticks once more") {
+            session.Tick(333);
+            auto delta = [&](std::uint64_t since) {
+                return json::parse(Write(model::api::responses::GetStateDeltaResponse{session.GetPlayers(), since,
+                                                                                      session.GetTick()}))
+                    .as_object();
+            };
+
+            THEN("a delta since the previous tick has only the moving dogs") {
+                auto state = delta(1);
+                CHECK(state.at("tick").to_number<std::uint64_t>() == 2);
+                CHECK(state.at("full") == json::value(false));
+                CHECK(state.at("players").as_object().size() == 5);
+            }
+
+            THEN("a delta since the start or from the future has every dog") {
+                CHECK(delta(0).at("players").as_object().size() == 10);
+                auto state = delta(3);
+                CHECK(state.at("full") == json::value(true));
+                CHECK(state.at("players").as_object().size() == 10);
+            }
+
+            THEN("a dog that only turned between ticks is in the next delta") {
+                CHECK(delta(2).at("players").as_object().empty());
+                session.GetPlayers().begin()->second->GetDog()->SetDirection(model::Direction::WEST);
+                CHECK(delta(2).at("players").as_object().size() == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include <boost/asio/io_context.hpp>
+
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/util/etag.hpp"
+#include "test_api.hpp"
+#include "test_maps.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+// Map endpoints respond inline, so the reply is ready as soon as Dispatch returns
+test::Reply Get(const api_handler::APIHandler &api, std::string_view target, std::string_view if_none_match = {}) {
+    auto request = test::MakeRequest(http::verb::get, target);
+    if (!if_none_match.empty()) {
+        request.set(http::field::if_none_match, if_none_match);
+    }
+    return test::Call(api, request);
+}
+
+} // namespace
+
+SCENARIO("Map responses are cached") {
+    GIVEN("an API over two maps") {
+        model::Game game{{test::MakeMap("map1"s, test::Road()), test::MakeMap("map2"s, test::Road())}};
+        boost::asio::io_context ioc;
+        api_handler::Strands strands{ioc, game.GetMaps()};
+        api_handler::APIHandler api{game, strands};
+
+        WHEN("the same map is requested twice") {
+            auto first = Get(api, "/api/v1/maps/map1"sv);
+            auto second = Get(api, "/api/v1/maps/map1?x=1"sv);
+
+            THEN("both responses carry the same body and tag") {
+                CHECK(first.code == 200);
+                CHECK(first.body.find(R"("id":"map1")") != std::string::npos);
+                CHECK(first.etag == util::MakeETag(first.body));
+                CHECK(second.body == first.body);
+                CHECK(second.etag == first.etag);
+            }
+
+            THEN("other maps and the map list have their own tags") {
+                CHECK(Get(api, "/api/v1/maps/map2"sv).etag != first.etag);
+                CHECK(Get(api, "/api/v1/maps"sv).etag != first.etag);
+            }
+        }
+
+        WHEN("the client already has the body") {
+            auto maps = Get(api, "/api/v1/maps"sv);
+            auto map = Get(api, "/api/v1/maps/map2"sv);
+
+            THEN("the server answers 304 without a body") {
+                auto not_modified = Get(api, "/api/v1/maps"sv, maps.etag);
+                CHECK(not_modified.code == 304);
+                CHECK(not_modified.etag == maps.etag);
+                CHECK(not_modified.body.empty());
+                CHECK(Get(api, "/api/v1/maps/map2"sv, "\"other\", W/" + map.etag).code == 304);
+                CHECK(Get(api, "/api/v1/maps/map2"sv, "*"sv).code == 304);
+            }
+
+            THEN("a stale tag gets the full body") {
+                CHECK(Get(api, "/api/v1/maps/map2"sv, maps.etag).code == 200);
+            }
+        }
+
+        WHEN("an unknown map is requested") {
+            THEN("it is not found") { CHECK(Get(api, "/api/v1/maps/map3"sv).code == 404); }
+        }
+
+        WHEN("a path under a map is requested") {
+            THEN("it is not found like an unknown map") {
+                CHECK(Get(api, "/api/v1/maps/map1/roads"sv).code == 404);
+                CHECK(Get(api, "/api/v1/maps/map1/"sv).code == 404);
+            }
+        }
+
+        WHEN("a path outside of the API routes is requested") {
+            THEN("it is a bad request") {
+                CHECK(Get(api, "/api/v1/maps/"sv).code == 400);
+                CHECK(Get(api, "/api/v2/maps"sv).code == 400);
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/util/metrics.hpp"
+
+using namespace std::literals;
+
+using util::Histogram;
+using util::MetricsRegistry;
+
+SCENARIO("Metrics registry") {
+    GIVEN("a registry") {
+        MetricsRegistry registry;
+
+        WHEN("a counter is incremented from several threads") {
+            auto &counter = registry.GetCounter("requests_total", "Requests", {{"route", "/api"}});
+            {
+                std::vector<std::jthread> threads;
+                for (int i = 0; i < 4; ++i) {
+                    threads.emplace_back([&counter] {
+                        for (int j = 0; j < 1000; ++j) {
+                            counter.Inc();
+                        }
+                    });
+                }
+            }
+
+            THEN("every increment is counted") { CHECK(counter.Value() == 4000); }
+
+            THEN("the same name and labels give the same counter") {
+                CHECK(&registry.GetCounter("requests_total", "Requests", {{"route", "/api"}}) == &counter);
+                CHECK(&registry.GetCounter("requests_total", "Requests", {{"route", "static"}}) != &counter);
+            }
+
+            THEN("a name cannot change its type") { CHECK_THROWS(registry.GetGauge("requests_total", "Requests")); }
+        }
+
+        WHEN("durations are observed") {
+            auto &histogram = registry.GetHistogram("latency_seconds", "Latency", {}, {0.001, 0.01});
+            histogram.Observe(500us);
+            histogram.Observe(1ms);
+            histogram.Observe(5ms);
+            histogram.Observe(2s);
+
+            THEN("they fall into the buckets of their upper bounds") {
+                auto snapshot = histogram.Collect();
+                CHECK(snapshot.buckets == std::vector<std::uint64_t>{2, 1, 1});
+                CHECK(snapshot.count == 4);
+                CHECK(snapshot.sum_seconds > 2.0064);
+                CHECK(snapshot.sum_seconds < 2.0066);
+            }
+        }
+
+        WHEN("the registry is exposed") {
+            registry.GetCounter("requests_total", "Requests", {{"route", "/api/v1/maps/{id}"}}).Inc(3);
+            registry.GetGauge("dogs", "Dogs on the map", {{"map", "say \"hi\""}}).Add(2);
+            registry.GetHistogram("latency_seconds", "Latency", {{"route", "static"}}, {0.5}).Observe(1s);
+            auto text = registry.Expose();
+
+            THEN("every family comes with its help and type") {
+                CHECK(text.find("# HELP requests_total Requests\n# TYPE requests_total counter\n") != text.npos);
+                CHECK(text.find("# TYPE dogs gauge\n") != text.npos);
+                CHECK(text.find("# TYPE latency_seconds histogram\n") != text.npos);
+            }
+
+            THEN("series carry their labels, escaped") {
+                CHECK(text.find("requests_total{route=\"/api/v1/maps/{id}\"} 3\n") != text.npos);
+                CHECK(text.find("dogs{map=\"say \\\"hi\\\"\"} 2\n") != text.npos);
+            }
+
+            THEN("histogram buckets are cumulative and end with +Inf") {
+                CHECK(text.find("latency_seconds_bucket{route=\"static\",le=\"0.5\"} 0\n") != text.npos);
+                CHECK(text.find("latency_seconds_bucket{route=\"static\",le=\"+Inf\"} 1\n") != text.npos);
+                CHECK(text.find("latency_seconds_sum{route=\"static\"} 1\n") != text.npos);
+                CHECK(text.find("latency_seconds_count{route=\"static\"} 1\n") != text.npos);
+            }
+        }
+    }
+}
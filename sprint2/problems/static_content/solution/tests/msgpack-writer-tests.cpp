@@ -0,0 +1,117 @@
+#include <initializer_list>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model/model.hpp"
+#include "../src/util/msgpack_writer.hpp"
+#include "test_maps.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+std::string Bytes(std::initializer_list<unsigned> bytes) {
+    std::string out;
+    for (auto byte : bytes) {
+        out.push_back(static_cast<char>(byte));
+    }
+    return out;
+}
+
+template <typename Fn>
+std::string Write(Fn &&fn) {
+    std::string out;
+    util::MsgPackWriter writer{out};
+    fn(writer);
+    return out;
+}
+
+} // namespace
+
+SCENARIO("MessagePack writer") {
+    WHEN("integers are written") {
+        THEN("each takes the shortest format") {
+            CHECK(Write([](auto &w) { w.Uint(5); }) == Bytes({0x05}));
+            CHECK(Write([](auto &w) { w.Uint(200); }) == Bytes({0xcc, 0xc8}));
+            CHECK(Write([](auto &w) { w.Uint(1000); }) == Bytes({0xcd, 0x03, 0xe8}));
+            CHECK(Write([](auto &w) { w.Uint(70000); }) == Bytes({0xce, 0x00, 0x01, 0x11, 0x70}));
+            CHECK(Write([](auto &w) { w.Uint(1ull << 32); }) ==
+                  Bytes({0xcf, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00}));
+        }
+    }
+
+    WHEN("strings and booleans are written") {
+        THEN("they are encoded big-endian after their headers") {
+            CHECK(Write([](auto &w) { w.String("dir"); }) == Bytes({0xa3, 'd', 'i', 'r'}));
+            CHECK(Write([](auto &w) { w.String(std::string(40, 'x')); }) == Bytes({0xd9, 40}) + std::string(40, 'x'));
+            CHECK(Write([](auto &w) { w.Bool(true).Bool(false); }) == Bytes({0xc3, 0xc2}));
+        }
+    }
+
+    WHEN("numbers are written") {
+        THEN("whole ones become integers") {
+            CHECK(Write([](auto &w) { w.Number(3.0).Number(-1.0); }) == Bytes({0x03, 0xff}));
+            CHECK(Write([](auto &w) { w.Number(-200.0); }) == Bytes({0xd1, 0xff, 0x38}));
+        }
+        THEN("fractions take a 4-byte float if it holds them exactly") {
+            CHECK(Write([](auto &w) { w.Number(1.5); }) == Bytes({0xca, 0x3f, 0xc0, 0x00, 0x00}));
+            CHECK(Write([](auto &w) { w.Number(0.1); }) ==
+                  Bytes({0xcb, 0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a}));
+        }
+    }
+
+    WHEN("containers are written") {
+        THEN("small ones carry their size in the header") {
+            CHECK(Write([](auto &w) { w.Map(2).Array(15).Array(16); }) == Bytes({0x82, 0x9f, 0xdc, 0x00, 0x10}));
+        }
+        THEN("a map of unknown size gets its size at the end") {
+            CHECK(Write([](auto &w) {
+                      auto map = w.BeginMap();
+                      w.Uint(1).Bool(true);
+                      w.EndMap(map, 1);
+                  }) == Bytes({0xdf, 0, 0, 0, 1, 0x01, 0xc3}));
+        }
+    }
+}
+
+SCENARIO("Responses as MessagePack") {
+    GIVEN("a session with one player") {
+        model::Game game{{test::MakeMap("map1"s, test::Road(), 1.5)}};
+        auto &session = game.AddSession(game.GetMaps().front());
+        auto [player, _] = game.AddPlayer("dog"s, session);
+        const auto id = static_cast<unsigned>(*player->GetId());
+        REQUIRE(id < 128);
+
+        THEN("players are a map from ids to names") {
+            auto out = Write([&](auto &w) {
+                model::api::responses::WriteMsgPack(w, model::api::responses::GetPlayersResponse{session.GetPlayers()});
+            });
+            CHECK(out == Bytes({0x81, id, 0x81, 0xa4, 'n', 'a', 'm', 'e', 0xa3, 'd', 'o', 'g'}));
+        }
+
+        THEN("the state holds the position, speed and direction of the dog") {
+            auto out = Write([&](auto &w) {
+                model::api::responses::WriteMsgPack(w, model::api::responses::GetStateResponse{session.GetPlayers()});
+            });
+            // {"players": {id: {"pos": [0, 0], "speed": [0, 0], "dir": "U"}}}, the dog stands at the start of the road
+            const auto dir = model::serialize(player->GetDog()->GetDirection());
+            REQUIRE(dir.size() == 1);
+            CHECK(out == Bytes({0x81, 0xa7, 'p', 'l', 'a', 'y', 'e', 'r', 's', 0x81, id, 0x83, 0xa3, 'p', 'o', 's',
+                                0x92, 0x00, 0x00, 0xa5, 's', 'p', 'e', 'e', 'd', 0x92, 0x00, 0x00, 0xa3, 'd', 'i', 'r',
+                                0xa1, static_cast<unsigned char>(dir[0])}));
+        }
+
+        WHEN("the delta is written for a tick after the last change") {
+            auto out = Write([&](auto &w) {
+                model::api::responses::WriteMsgPack(
+                    w, model::api::responses::GetStateDeltaResponse{session.GetPlayers(), 5, 5});
+            });
+
+            THEN("its map of players is empty") {
+                CHECK(out == Bytes({0x83, 0xa4, 't', 'i', 'c', 'k', 0x05, 0xa4, 'f', 'u', 'l', 'l', 0xc2, 0xa7, 'p',
+                                    'l', 'a', 'y', 'e', 'r', 's', 0xdf, 0, 0, 0, 0}));
+            }
+        }
+    }
+}
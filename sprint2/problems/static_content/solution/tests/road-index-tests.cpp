@@ -0,0 +1,67 @@
+#include <limits>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model/model.hpp"
+
+using namespace std::literals;
+
+using model::Orientation;
+using model::Point;
+using model::RoadIndex;
+
+namespace {
+
+// The same street with the same crossroad near the origin, plus another road at the given point
+model::Map::Roads MakeRoads(Point far_away) {
+    return {{Orientation::HORIZONTAL, {0, 0}, 10},
+            {Orientation::HORIZONTAL, {20, 0}, 5},
+            {Orientation::VERTICAL, {5, -5}, 5},
+            {Orientation::HORIZONTAL, far_away, far_away.x + 10}};
+}
+
+} // namespace
+
+SCENARIO("Road index") {
+    GIVEN("a small map") {
+        const auto roads = MakeRoads({100, 100});
+        const RoadIndex index{roads};
+
+        THEN("it is a grid") {
+            CHECK(index.IsDense());
+            CHECK(index.Find(Orientation::HORIZONTAL, {3, 0}) == 0);
+            CHECK(index.Find(Orientation::VERTICAL, {5, 3}) == 2);
+            CHECK(index.Find(Orientation::HORIZONTAL, {105, 100}) == 3);
+            CHECK(index.Find(Orientation::VERTICAL, {3, 0}) == RoadIndex::NO_ROAD);
+        }
+    }
+
+    GIVEN("a map with roads far apart") {
+        constexpr auto far = std::numeric_limits<model::Coord>::max() - 10;
+        const auto roads = MakeRoads({far, far});
+        const RoadIndex index{roads};
+
+        THEN("it takes intervals instead of a grid over the whole map") {
+            CHECK(!index.IsDense());
+        }
+        THEN("points on roads are found") {
+            CHECK(index.Find(Orientation::HORIZONTAL, {0, 0}) == 0);
+            CHECK(index.Find(Orientation::HORIZONTAL, {10, 0}) != RoadIndex::NO_ROAD);
+            CHECK(index.Find(Orientation::HORIZONTAL, {20, 0}) == 1);
+            CHECK(index.Find(Orientation::VERTICAL, {5, -5}) == 2);
+            CHECK(index.Find(Orientation::HORIZONTAL, {far + 10, far}) == 3);
+        }
+        THEN("points off roads are not") {
+            CHECK(index.Find(Orientation::HORIZONTAL, {21, 0}) == RoadIndex::NO_ROAD);
+            CHECK(index.Find(Orientation::HORIZONTAL, {-1, 0}) == RoadIndex::NO_ROAD);
+            CHECK(index.Find(Orientation::HORIZONTAL, {3, 1}) == RoadIndex::NO_ROAD);
+            CHECK(index.Find(Orientation::VERTICAL, {5, 6}) == RoadIndex::NO_ROAD);
+            CHECK(index.Find(Orientation::HORIZONTAL, {far - 1, far}) == RoadIndex::NO_ROAD);
+        }
+        THEN("a map is built from them") {
+            auto map_roads = roads;
+            const model::Map map{model::Map::Id{"far"s}, "Far"s, std::move(map_roads), {}, {}};
+            CHECK(map.FindRoad(Orientation::HORIZONTAL, {far, far}) != nullptr);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/api_handler/router.hpp"
+
+using namespace std::literals;
+
+using api_handler::MethodsOf;
+using verb = boost::beast::http::verb;
+
+SCENARIO("Router") {
+    GIVEN("the API route table") {
+        const auto get = MethodsOf({verb::get, verb::head});
+        const auto post = MethodsOf({verb::post});
+        api_handler::Router<std::string> router;
+        router.Add("/api/v1/maps", get, "maps"s);
+        router.Add("/api/v1/maps/{id}", get, "map"s);
+        router.Add("/api/v1/maps/{id}/*", get, "map"s);
+        router.Add("/api/v1/game/join", post, "join"s);
+        router.Add("/api/v1/game/player/action", post, "action"s);
+        router.Add("/api/*", ~api_handler::Methods{0}, "fallthrough"s);
+
+        auto find = [&](std::string_view target) {
+            auto match = router.Find(target);
+            return match.target ? *match.target : "none"s;
+        };
+
+        THEN("exact routes and parameters are resolved") {
+            CHECK(find("/api/v1/maps") == "maps");
+            CHECK(find("/api/v1/maps/map1") == "map");
+            CHECK(find("/api/v1/game/player/action") == "action");
+            CHECK(find("/api/v1/game/join?debug=1") == "join");
+            CHECK(find("/api/v1/maps/map1/roads") == "map");
+            CHECK(find("/api/v1/maps/map1/") == "map");
+        }
+
+        THEN("unknown API targets fall through and other targets are not routed") {
+            CHECK(find("/api/v1/maps/") == "fallthrough");
+            CHECK(find("/api/v2/game") == "fallthrough");
+            CHECK(find("/api/") == "fallthrough");
+            CHECK(find("/api") == "none");
+            CHECK(find("/index.html") == "none");
+        }
+
+        THEN("the allowed methods come with the match") {
+            auto match = router.Find("/api/v1/game/join");
+            CHECK(match.MethodAllowed(verb::post));
+            CHECK_FALSE(match.MethodAllowed(verb::get));
+            CHECK(router.Find("/api/v1/maps/map1").MethodAllowed(verb::head));
+        }
+
+        THEN("the match names its route") {
+            CHECK(router.Find("/api/v1/maps/map1").pattern == "/api/v1/maps/{id}");
+            CHECK(router.Find("/api/v1/maps?all").pattern == "/api/v1/maps");
+            CHECK(router.Find("/api/v1/maps/map1/roads").pattern == "/api/v1/maps/{id}/*");
+            CHECK(router.Find("/api/v2").pattern == "/api/*");
+            CHECK(router.Patterns().size() == 6);
+        }
+
+        THEN("a route cannot be registered twice") {
+            CHECK_THROWS(router.Add("/api/v1/maps", get, "again"s));
+            CHECK_THROWS(router.Add("/api/v1/maps/{name}", get, "again"s));
+            CHECK_THROWS(router.Add("/api/v1/maps/{name}/*", get, "again"s));
+            CHECK_THROWS(router.Add("/api/*", get, "again"s));
+        }
+    }
+}
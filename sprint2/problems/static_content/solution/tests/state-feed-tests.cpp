@@ -0,0 +1,96 @@
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/api_handler/state_feed.hpp"
+#include "test_maps.hpp"
+
+using namespace std::literals;
+
+namespace {
+
+class RecordingSubscriber : public api_handler::StateFeed::Subscriber {
+  public:
+    struct Pushed {
+        api_handler::StateFeed::Message message;
+        bool full;
+    };
+
+    bool Push(const api_handler::StateFeed::Message &message, bool full) override {
+        pushed.push_back({message, full});
+        return open;
+    }
+    bool TakeLagged() override { return std::exchange(lagged, false); }
+
+    std::vector<Pushed> pushed;
+    bool open = true;
+    bool lagged = false;
+};
+
+} // namespace
+
+SCENARIO("State feed") {
+    GIVEN("a session with two subscribers") {
+        model::Game game{{test::MakeMap("map1"s, test::Road(), 1.0)}};
+        const auto &map = game.GetMaps().front();
+        auto &session = game.AddSession(map);
+        auto [player, _] = game.AddPlayer("dog"s, session);
+
+        api_handler::StateFeed feed{game.GetMaps()};
+        auto first = std::make_shared<RecordingSubscriber>();
+        auto second = std::make_shared<RecordingSubscriber>();
+        feed.Subscribe(session, first);
+        feed.Subscribe(session, second);
+
+        THEN("each gets the full state on subscribing") {
+            REQUIRE(first->pushed.size() == 1);
+            CHECK(first->pushed.front().full);
+            CHECK(first->pushed.front().message->find(R"("full":true)") != std::string::npos);
+            CHECK(feed.Subscribers(map.GetId()) == 2);
+        }
+
+        WHEN("the session ticks") {
+            player->GetDog()->SetSpeed({1.0, 0.0});
+            session.Tick(100);
+            feed.Publish(session);
+
+            THEN("both get the same delta buffer") {
+                REQUIRE(first->pushed.size() == 2);
+                REQUIRE(second->pushed.size() == 2);
+                CHECK_FALSE(first->pushed.back().full);
+                CHECK(first->pushed.back().message == second->pushed.back().message);
+                CHECK(first->pushed.back().message->starts_with(R"({"tick":1,"full":false,"players":{")"));
+                CHECK(first->pushed.back().message->find(R"("pos":[0.1,0])") != std::string::npos);
+            }
+        }
+
+        WHEN("a subscriber has lost messages") {
+            second->lagged = true;
+            session.Tick(100);
+            feed.Publish(session);
+
+            THEN("it gets the full state and the other one the delta") {
+                CHECK_FALSE(first->pushed.back().full);
+                CHECK(second->pushed.back().full);
+                CHECK(second->pushed.back().message->find(R"("pos":)") != std::string::npos);
+            }
+        }
+
+        WHEN("a subscriber is gone") {
+            first->open = false;
+            session.Tick(100);
+            feed.Publish(session);
+            session.Tick(100);
+            feed.Publish(session);
+
+            THEN("it is not published to anymore") {
+                CHECK(first->pushed.size() == 2);
+                CHECK(second->pushed.size() == 3);
+                CHECK(feed.Subscribers(map.GetId()) == 1);
+            }
+        }
+    }
+}
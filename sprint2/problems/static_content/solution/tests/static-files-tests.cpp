@@ -0,0 +1,304 @@
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/static_content/range.hpp"
+#include "../src/static_content/static_files.hpp"
+#include "../src/util/http_date.hpp"
+#include "../src/util/mime_type.hpp"
+
+using namespace std::literals;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Status = static_content::StaticFiles::Lookup::Status;
+
+void WriteFile(const fs::path &path, std::string_view content) {
+    fs::create_directories(path.parent_path());
+    std::ofstream{path, std::ios::binary} << content;
+}
+
+// Fresh www root, removed with everything in it at the end of the test
+class TempRoot {
+  public:
+    TempRoot() : path_(fs::temp_directory_path() / ("static-files-tests-"s + std::to_string(::getpid()))) {
+        fs::remove_all(path_);
+        fs::create_directories(path_);
+    }
+    ~TempRoot() { fs::remove_all(path_); }
+
+    const fs::path &Path() const { return path_; }
+
+  private:
+    fs::path path_;
+};
+
+} // namespace
+
+SCENARIO("Static files catalog") {
+    GIVEN("a www root with small and large files") {
+        TempRoot root;
+        WriteFile(root.Path() / "index.html", "<html></html>");
+        WriteFile(root.Path() / "js" / "game.js", "let x = 1;");
+        WriteFile(root.Path() / "assets" / "big.bin", std::string(4096, 'x'));
+
+        boost::asio::io_context ioc;
+        static_content::StaticFiles files{ioc, root.Path(), {.max_cached_file = 1024, .max_cached_total = 1 << 20}};
+
+        THEN("files are found by their targets with their mime types") {
+            auto index = files.Find("/"sv);
+            REQUIRE(index.status == Status::FOUND);
+            CHECK(index.file->mime_type == "text/html");
+            CHECK(files.Find("/index.html?v=2"sv).file == index.file);
+
+            auto script = files.Find("/js/game.js"sv);
+            REQUIRE(script.status == Status::FOUND);
+            CHECK(script.file->mime_type == "application/javascript");
+            CHECK(files.Find("/js/./../js//game.js"sv).file == script.file);
+        }
+
+        THEN("small files are kept in memory and large ones are not") {
+            auto script = files.Find("/js/game.js"sv);
+            REQUIRE(script.file->content);
+            CHECK(*script.file->content == "let x = 1;");
+
+            auto big = files.Find("/assets/big.bin"sv);
+            REQUIRE(big.status == Status::FOUND);
+            CHECK(big.file->size == 4096);
+            CHECK(!big.file->content);
+        }
+
+        THEN("targets outside the root are invalid and unknown ones are not found") {
+            CHECK(files.Find("/../etc/passwd"sv).status == Status::INVALID_PATH);
+            CHECK(files.Find("/js/../../index.html"sv).status == Status::INVALID_PATH);
+            CHECK(files.Find("/missing.html"sv).status == Status::NOT_FOUND);
+            CHECK(files.Find("/js"sv).status == Status::NOT_FOUND);
+        }
+
+        THEN("every file gets validators of its own") {
+            auto index = files.Find("/"sv).file;
+            auto script = files.Find("/js/game.js"sv).file;
+            CHECK(index->etag.starts_with('"'));
+            CHECK(index->etag.ends_with('"'));
+            CHECK(index->etag != script->etag);
+            CHECK(util::ParseHttpDate(index->last_modified) == index->modified);
+        }
+
+        WHEN("a file is added and the catalog is reloaded") {
+            auto old_index = files.Find("/"sv).file;
+            WriteFile(root.Path() / "about.html", "about");
+            files.Reload();
+
+            THEN("the new file is served and old lookups stay valid") {
+                CHECK(files.Find("/about.html"sv).status == Status::FOUND);
+                CHECK(*old_index->content == "<html></html>");
+            }
+        }
+
+#ifdef __linux__
+        WHEN("the root is watched and changes") {
+            files.Watch();
+            ioc.poll();
+            WriteFile(root.Path() / "js" / "new.js", "1");
+
+            THEN("the catalog picks the change up by itself") {
+                auto deadline = std::chrono::steady_clock::now() + 5s;
+                while (files.Find("/js/new.js"sv).status != Status::FOUND && std::chrono::steady_clock::now() < deadline) {
+                    ioc.run_for(20ms);
+                }
+                CHECK(files.Find("/js/new.js"sv).status == Status::FOUND);
+            }
+        }
+#endif
+    }
+}
+
+SCENARIO("Compressed representations of static files") {
+    GIVEN("a www root with a script that compresses well and an image") {
+        TempRoot root;
+        std::string script;
+        for (int i = 0; i < 200; ++i) {
+            script += "function f" + std::to_string(i) + "() { return " + std::to_string(i) + "; }\n";
+        }
+        WriteFile(root.Path() / "game.js", script);
+        WriteFile(root.Path() / "road.png", script);
+
+        boost::asio::io_context ioc;
+        static_content::StaticFiles files{ioc, root.Path()};
+        auto file = files.Find("/game.js"sv).file;
+
+        THEN("the script gets gzip and brotli representations and the image does not") {
+            REQUIRE(file->gzip);
+            REQUIRE(file->brotli);
+            CHECK(file->brotli->size < script.size() / 2);
+            CHECK(!files.Find("/road.png"sv).file->HasEncodings());
+        }
+
+        THEN("the representation follows Accept-Encoding") {
+            CHECK(file->Select(""sv).encoding.empty());
+            CHECK(file->Select(""sv).content == file->content);
+            CHECK(file->Select("gzip, deflate, br"sv).encoding == "br");
+            CHECK(file->Select("gzip, deflate, br"sv).content == file->brotli->content);
+            CHECK(file->Select("gzip"sv).encoding == "gzip");
+            CHECK(file->Select("br;q=0.5, GZIP;q=0.8"sv).encoding == "gzip");
+            CHECK(file->Select("br;q=0, *"sv).encoding == "gzip");
+            CHECK(file->Select("*"sv).encoding == "br");
+            CHECK(file->Select("deflate, identity"sv).encoding.empty());
+        }
+
+        THEN("each representation has its own tag") {
+            CHECK(file->Select(""sv).etag == file->etag);
+            CHECK(file->Select("br"sv).etag != file->etag);
+            CHECK(file->Select("gzip"sv).etag != file->Select("br"sv).etag);
+        }
+
+        WHEN("an up to date .gz file lies next to the script") {
+            WriteFile(root.Path() / "game.js.gz", "precompressed");
+            fs::last_write_time(root.Path() / "game.js.gz", fs::last_write_time(root.Path() / "game.js"));
+            files.Reload();
+
+            THEN("it is served instead of compressing the script") {
+                auto reloaded = files.Find("/game.js"sv).file;
+                REQUIRE(reloaded->gzip);
+                CHECK(*reloaded->gzip->content == "precompressed");
+                CHECK(reloaded->Select("gzip"sv).encoding == "gzip");
+            }
+        }
+    }
+}
+
+SCENARIO("Memory budget of static files") {
+    GIVEN("a catalog with room in memory for one of its files") {
+        TempRoot root;
+        WriteFile(root.Path() / "a.bin", std::string(600, 'a'));
+        WriteFile(root.Path() / "b.bin", std::string(600, 'b'));
+
+        boost::asio::io_context ioc;
+        static_content::StaticFiles files{ioc, root.Path(), {.max_cached_file = 1024, .max_cached_total = 1000}};
+        const std::vector<std::string> targets{"/a.bin", "/b.bin", "/c.bin", "/d.bin", "/e.js"};
+
+        // Bytes of the catalog kept in memory, contents and compressed representations
+        auto cached = [&] {
+            std::uintmax_t total = 0;
+            for (const auto &target : targets) {
+                auto file = files.Find(target).file;
+                if (!file) {
+                    continue;
+                }
+                total += file->content ? file->content->size() : 0;
+                for (const auto *encoded : {&file->gzip, &file->brotli}) {
+                    total += *encoded && (*encoded)->path.empty() ? (*encoded)->content->size() : 0;
+                }
+            }
+            return total;
+        };
+        REQUIRE(cached() == 600);
+
+        WHEN("files are added and the catalog is reloaded") {
+            WriteFile(root.Path() / "c.bin", std::string(600, 'c'));
+            WriteFile(root.Path() / "d.bin", std::string(600, 'd'));
+            std::string script;
+            for (int i = 0; i < 20; ++i) {
+                script += "var v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+            }
+            WriteFile(root.Path() / "e.js", script);
+            files.Reload();
+            files.Reload();
+
+            THEN("files kept from the previous catalog count against the budget too") {
+                CHECK(cached() <= 1000);
+            }
+        }
+    }
+}
+
+SCENARIO("Range requests") {
+    using static_content::ParseRange;
+    using RangeStatus = static_content::RangeRequest::Status;
+
+    GIVEN("a representation of 1000 bytes") {
+        constexpr std::uint64_t size = 1000;
+
+        THEN("single ranges are resolved and trimmed to the size") {
+            auto ranges = ParseRange("bytes=0-499"sv, size);
+            REQUIRE(ranges.status == RangeStatus::PARTIAL);
+            REQUIRE(ranges.ranges.size() == 1);
+            CHECK(ranges.ranges[0].first == 0);
+            CHECK(ranges.ranges[0].Size() == 500);
+
+            CHECK(ParseRange("bytes=900-"sv, size).ranges[0].last == 999);
+            CHECK(ParseRange("bytes=900-5000"sv, size).ranges[0].last == 999);
+            CHECK(ParseRange("bytes=-100"sv, size).ranges[0].first == 900);
+            CHECK(ParseRange("bytes=-5000"sv, size).ranges[0].first == 0);
+        }
+
+        THEN("several ranges are kept in order") {
+            auto ranges = ParseRange("bytes=0-0, 10-19 ,-1"sv, size);
+            REQUIRE(ranges.status == RangeStatus::PARTIAL);
+            REQUIRE(ranges.ranges.size() == 3);
+            CHECK(ranges.ranges[1].first == 10);
+            CHECK(ranges.ranges[2].first == 999);
+        }
+
+        THEN("ranges past the end are unsatisfiable") {
+            CHECK(ParseRange("bytes=1000-"sv, size).status == RangeStatus::UNSATISFIABLE);
+            CHECK(ParseRange("bytes=-0"sv, size).status == RangeStatus::UNSATISFIABLE);
+            CHECK(ParseRange("bytes=0-1"sv, 0).status == RangeStatus::UNSATISFIABLE);
+        }
+
+        THEN("malformed headers and too many ranges are ignored") {
+            CHECK(ParseRange("items=0-1"sv, size).status == RangeStatus::WHOLE);
+            CHECK(ParseRange("bytes=5-1"sv, size).status == RangeStatus::WHOLE);
+            CHECK(ParseRange("bytes=a-b"sv, size).status == RangeStatus::WHOLE);
+            CHECK(ParseRange("bytes="sv, size).status == RangeStatus::WHOLE);
+
+            std::string many = "bytes=0-0";
+            for (int i = 1; i <= 16; ++i) {
+                many += "," + std::to_string(i) + "-" + std::to_string(i);
+            }
+            CHECK(ParseRange(many, size).status == RangeStatus::WHOLE);
+        }
+    }
+
+    GIVEN("an HTTP date") {
+        THEN("it survives formatting and parsing") {
+            auto date = util::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"sv);
+            REQUIRE(date);
+            CHECK(util::FormatHttpDate(*date) == "Sun, 06 Nov 1994 08:49:37 GMT");
+            CHECK(!util::ParseHttpDate("yesterday"sv));
+        }
+    }
+}
+
+SCENARIO("Mime types") {
+    using util::GetMimeType;
+
+    THEN("known extensions are found in any case") {
+        CHECK(GetMimeType("index.html"sv) == "text/html");
+        CHECK(GetMimeType("INDEX.HTM"sv) == "text/html");
+        CHECK(GetMimeType("/js/game.mjs"sv) == "application/javascript");
+        CHECK(GetMimeType("game.js.map"sv) == "application/json");
+        CHECK(GetMimeType("physics.wasm"sv) == "application/wasm");
+        CHECK(GetMimeType("road.WebP"sv) == "image/webp");
+        CHECK(GetMimeType("font.woff2"sv) == "font/woff2");
+        CHECK(GetMimeType("font.woff"sv) == "font/woff");
+    }
+
+    THEN("anything else is a byte stream") {
+        CHECK(GetMimeType("README"sv) == "application/octet-stream");
+        CHECK(GetMimeType("archive.tar.gz2"sv) == "application/octet-stream");
+        CHECK(GetMimeType("file."sv) == "application/octet-stream");
+        CHECK(GetMimeType("data.unknown"sv) == "application/octet-stream");
+    }
+}
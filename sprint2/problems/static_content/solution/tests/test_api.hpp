@@ -0,0 +1,62 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "../src/api_handler/api_handler.hpp"
+
+namespace test {
+
+struct Reply {
+    unsigned code = 0;
+    std::string etag;
+    std::string body;
+};
+
+inline http::request<http::string_body> MakeRequest(http::verb method, std::string_view target,
+                                                    std::string_view token = {}, std::string body = {}) {
+    http::request<http::string_body> request{method, target, 11};
+    if (!token.empty()) {
+        request.set(http::field::authorization, "Bearer " + std::string{token});
+    }
+    if (!body.empty()) {
+        request.set(http::field::content_type, "application/json");
+        request.body() = std::move(body);
+        request.prepare_payload();
+    }
+    return request;
+}
+
+// Status, tag and body of a response, the body stays empty for files
+inline Reply ReplyOf(util::Response &&response) {
+    Reply reply;
+    response.send([&reply]<typename Body, typename Fields>(http::response<Body, Fields> &&message) {
+        reply.code = message.result_int();
+        reply.etag = message[http::field::etag];
+        if constexpr (std::is_same_v<Body, util::SharedBody>) {
+            reply.body = *message.body();
+        } else if constexpr (std::is_same_v<Body, http::string_body>) {
+            reply.body = std::move(message.body());
+        }
+    });
+    return reply;
+}
+
+// Runs the request through the API and waits for the response, which may come from any io_context thread.
+// Code 0 means that no API route matches the target.
+inline Reply Call(const api_handler::APIHandler &api, const http::request<http::string_body> &request) {
+    auto match = api.Find(request.target());
+    if (!match.target) {
+        return {};
+    }
+    auto promise = std::make_shared<std::promise<Reply>>();
+    auto future = promise->get_future();
+    api.Dispatch(match, request, [promise](util::Response &&response) {
+        promise->set_value(ReplyOf(std::move(response)));
+    });
+    return future.get();
+}
+
+} // namespace test
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "../src/model/model.hpp"
+
+namespace test {
+
+// Map named after its id, without a dog speed of its own unless it is given
+inline model::Map MakeMap(std::string id, model::Map::Roads roads, std::optional<double> dog_speed = std::nullopt) {
+    auto map = model::Map{model::Map::Id{id}, id, std::move(roads), {}, {}};
+    if (dog_speed) {
+        map.SetDogSpeed(*dog_speed);
+    }
+    return map;
+}
+
+// A horizontal road from (0, 0) to (40, 0)
+inline model::Map::Roads Road() {
+    return {{model::Orientation::HORIZONTAL, {0, 0}, 40}};
+}
+
+// The same road turning into a vertical one from (40, 0) to (40, 30)
+inline model::Map::Roads Corner() {
+    return {{model::Orientation::HORIZONTAL, {0, 0}, 40}, {model::Orientation::VERTICAL, {40, 0}, 30}};
+}
+
+// A closed 40 x 30 rectangle of four roads, two of them drawn backwards
+inline model::Map::Roads Square() {
+    return {{model::Orientation::HORIZONTAL, {0, 0}, 40},
+            {model::Orientation::VERTICAL, {40, 0}, 30},
+            {model::Orientation::HORIZONTAL, {40, 30}, 0},
+            {model::Orientation::VERTICAL, {0, 0}, 30}};
+}
+
+} // namespace test
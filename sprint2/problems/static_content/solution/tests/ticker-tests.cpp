@@ -0,0 +1,157 @@
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/util/ticker.hpp"
+
+using namespace std::literals;
+
+namespace net = boost::asio;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Run {
+    std::vector<std::chrono::milliseconds> deltas;
+    Clock::duration elapsed;
+};
+
+// Runs the ticker for the given time, the handler stalls the strand for `pause` on its second tick
+Run RunTicker(util::TickerOptions options, std::chrono::milliseconds period, Clock::duration duration,
+              std::chrono::milliseconds pause) {
+    net::io_context ioc;
+    Run run;
+    auto ticker = std::make_shared<util::Ticker>(net::make_strand(ioc), period,
+                                                 [&run, pause](std::chrono::milliseconds delta) {
+                                                     run.deltas.push_back(delta);
+                                                     if (run.deltas.size() == 2) {
+                                                         std::this_thread::sleep_for(pause);
+                                                     }
+                                                 },
+                                                 options);
+    const auto start = Clock::now();
+    ticker->Start();
+    ioc.run_for(duration);
+    run.elapsed = Clock::now() - start;
+    return run;
+}
+
+std::uint64_t CounterValue(std::string_view name) {
+    // The ticker has registered the counter, the help text is ignored for existing metrics
+    return util::Metrics().GetCounter(name, ""sv).Value();
+}
+
+} // namespace
+
+SCENARIO("Ticker") {
+    constexpr auto period = 20ms;
+
+    GIVEN("a ticker with variable ticks") {
+        WHEN("the strand stalls") {
+            auto run = RunTicker({}, period, 300ms, 100ms);
+
+            THEN("one tick takes the whole pause") {
+                REQUIRE(run.deltas.size() >= 3);
+                CHECK(run.deltas[2] >= 100ms);
+            }
+        }
+    }
+
+    GIVEN("a ticker with fixed ticks") {
+        const util::TickerOptions options{util::TickMode::FIXED, 3};
+        const auto catch_up = CounterValue("game_ticker_catch_up_ticks_total"sv);
+        const auto dropped = CounterValue("game_ticker_dropped_ticks_total"sv);
+
+        WHEN("the strand stalls for more ticks than may be caught up") {
+            auto run = RunTicker(options, period, 300ms, 110ms);
+
+            THEN("every tick is one period long") {
+                REQUIRE(run.deltas.size() >= 3);
+                for (auto delta : run.deltas) {
+                    CHECK(delta == period);
+                }
+            }
+            THEN("the game does not run ahead of the real time") {
+                CHECK(run.deltas.size() * period <= run.elapsed);
+            }
+            THEN("the catch-up ticks and the skipped ones are counted") {
+                CHECK(CounterValue("game_ticker_catch_up_ticks_total"sv) - catch_up >= 2);
+                CHECK(CounterValue("game_ticker_dropped_ticks_total"sv) - dropped >= 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Pending ticks") {
+    constexpr auto period = 20ms;
+
+    GIVEN("fixed ticks passed on to a strand that has stalled") {
+        util::PendingTicks pending{period, {util::TickMode::FIXED, 3}};
+        const auto dropped = CounterValue("game_ticker_dropped_ticks_total"sv);
+
+        CHECK(pending.Add(period));
+        for (int i = 0; i < 4; ++i) {
+            CHECK(!pending.Add(period));
+        }
+
+        WHEN("the strand gets free") {
+            auto ticks = pending.Take();
+
+            THEN("it catches up as much as allowed and the rest is dropped") {
+                CHECK(ticks.count == 3);
+                CHECK(ticks.delta == period);
+                CHECK(CounterValue("game_ticker_dropped_ticks_total"sv) - dropped == 2);
+            }
+            THEN("nothing is left and the next tick has to be posted again") {
+                CHECK(pending.Take().count == 0);
+                CHECK(pending.Add(period));
+            }
+        }
+    }
+
+    GIVEN("variable ticks passed on to a strand that has stalled") {
+        util::PendingTicks pending{period, {}};
+        CHECK(pending.Add(25ms));
+        CHECK(!pending.Add(30ms));
+
+        THEN("they make one tick of all the time") {
+            auto ticks = pending.Take();
+            CHECK(ticks.count == 1);
+            CHECK(ticks.delta == 55ms);
+        }
+    }
+}
+
+SCENARIO("Tick limiter") {
+    GIVEN("a limiter of two ticks at once") {
+        util::TickLimiter limiter{2};
+        std::vector<int> started;
+        for (int i = 0; i < 4; ++i) {
+            limiter.Run([&started, i] { started.push_back(i); });
+        }
+
+        THEN("ticks over the cap wait") {
+            CHECK(started == std::vector{0, 1});
+        }
+
+        WHEN("running ticks are done") {
+            limiter.Done();
+            limiter.Done();
+
+            THEN("the waiting ones start in the order they came") {
+                CHECK(started == std::vector{0, 1, 2, 3});
+            }
+            THEN("there is room for no more than the cap") {
+                limiter.Run([&started] { started.push_back(4); });
+                CHECK(started.size() == 4);
+                limiter.Done();
+                CHECK(started.size() == 5);
+            }
+        }
+    }
+}
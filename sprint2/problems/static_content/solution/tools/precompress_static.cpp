@@ -0,0 +1,61 @@
+// Writes file.gz and file.br next to every compressible file under the www root, compressed with the
+// strongest settings. The server picks them up instead of compressing those files itself on startup.
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "static_content/static_files.hpp"
+#include "util/compression.hpp"
+#include "util/mime_type.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Same rule as the server: a representation that does not save a tenth of the size is not worth it
+bool WriteEncoded(const fs::path &source, std::string_view suffix, const std::optional<std::string> &compressed,
+                  std::size_t size) {
+    auto target = source;
+    target += suffix;
+    if (!compressed || compressed->size() >= size - size / 10) {
+        fs::remove(target);
+        return false;
+    }
+    std::ofstream{target, std::ios::binary}.write(compressed->data(), compressed->size());
+    // Same time as the source, so the sibling counts as up to date
+    fs::last_write_time(target, fs::last_write_time(source));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: precompress_static <www-root>\n";
+        return EXIT_FAILURE;
+    }
+
+    std::size_t files = 0, original = 0, compressed = 0;
+    for (const auto &entry : fs::recursive_directory_iterator{argv[1]}) {
+        if (!entry.is_regular_file() ||
+            !static_content::StaticFiles::IsCompressible(util::GetMimeType(entry.path().extension().string()))) {
+            continue;
+        }
+
+        std::ifstream in{entry.path(), std::ios::binary};
+        std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        auto gzip = util::Gzip(data, 9);
+        auto brotli = util::Brotli(data, 11);
+        WriteEncoded(entry.path(), ".gz", gzip, data.size());
+        if (WriteEncoded(entry.path(), ".br", brotli, data.size())) {
+            ++files;
+            original += data.size();
+            compressed += brotli->size();
+        }
+    }
+
+    std::cout << "files: " << files << ", " << original << " bytes, brotli: " << compressed << " bytes\n";
+    return EXIT_SUCCESS;
+}